@@ -7,6 +7,7 @@
 
 #include "arraytools.h"
 #include "arrayproperties.h"
+#include "strength.h"
 
 #ifdef DOOPENMP
 #include "omp.h"
@@ -30,14 +31,40 @@
 #endif
 
 
-DoptimReturn Doptimize ( const arraydata_t &arrayclass, int nrestartsmax, std::vector<double> alpha, int verbose, int method, int niter, double maxtime , int nabort )
+/// return true if the number of runs is a multiple of the product of the factor levels of every combination of t columns
+static bool strengthDivisible ( const arraydata_t &arrayclass, int t )
+{
+	t = std::min ( t, ( int ) arrayclass.ncols );
+	if ( t<=0 )
+		return true;
+	std::vector<int> comb ( t );
+	for ( int j=0; j<t; j++ )
+		comb[j]=j;
+	do {
+		long prod=1;
+		for ( int j=0; j<t; j++ )
+			prod *= arrayclass.s[comb[j]];
+		if ( arrayclass.N % prod != 0 )
+			return false;
+	} while ( next_comb ( comb, t, arrayclass.ncols ) );
+	return true;
+}
+
+DoptimReturn Doptimize ( const arraydata_t &arrayclass, int nrestartsmax, std::vector<double> alpha, int verbose, int method, int niter, double maxtime , int nabort, int strength, int dedupe )
 {
 	if ( method==DOPTIM_AUTOMATIC )
 		method = DOPTIM_UPDATE;
 
+	if ( strength>0 && ! strengthDivisible ( arrayclass, strength ) ) {
+		myprintf ( "Doptimize: no design with %d runs and strength %d exists, the number of runs is not a multiple of the number of level combinations\n", arrayclass.N, strength );
+		DoptimReturn a = {std::vector<std::vector<double> >(), arraylist_t(), 0, 0};
+		return a;
+	}
+
 	double t0 = get_time_ms();
 	std::vector<std::vector<double> > dds;
 	arraylist_t AA;
+	std::multimap<unsigned long long, int> hashes;	// hash values of the stored designs
 
 	bool abort=false;
 	int nrestarts=0;
@@ -62,7 +89,9 @@ DoptimReturn Doptimize ( const arraydata_t &arrayclass, int nrestartsmax, std::v
 		array_link al = arrayclass.randomarray ( 1 );
 
 
-		array_link  A = optimDeff ( al,  arrayclass, alpha, verbose>=2, method, niter,  nabort );
+		array_link  A = optimDeff ( al,  arrayclass, alpha, verbose>=2, method, niter,  nabort, strength );
+		// designs without the requested strength are not stored
+		const bool valid = strength<=0 || strength_check ( A, strength );
 		std::vector<double> dd = A.Defficiencies();
 		if ( verbose>=2 ) {
 			#ifdef DOOPENMP
@@ -76,12 +105,29 @@ DoptimReturn Doptimize ( const arraydata_t &arrayclass, int nrestartsmax, std::v
 		
 		}
 
+		const unsigned long long h = dedupe ? A.hashvalue() : 0;
+
 #ifdef DOOPENMP
 		#pragma omp critical
 #endif
 		{
-			AA.push_back ( A );
-			dds.push_back ( dd );
+			bool duplicate=false;
+			if ( dedupe && valid ) {
+				typedef std::multimap<unsigned long long, int>::const_iterator iterator_t;
+				std::pair<iterator_t, iterator_t> range = hashes.equal_range ( h );
+				for ( iterator_t it=range.first; it!=range.second; ++it ) {
+					if ( AA[it->second]==A ) {
+						duplicate=true;
+						break;
+					}
+				}
+			}
+			if ( valid && ! duplicate ) {
+				if ( dedupe )
+					hashes.insert ( std::pair<unsigned long long, int> ( h, AA.size() ) );
+				AA.push_back ( OA_MOVE ( A ) );
+				dds.push_back ( OA_MOVE ( dd ) );
+			}
 			nrestarts++;
 		}
 
@@ -96,7 +142,7 @@ DoptimReturn Doptimize ( const arraydata_t &arrayclass, int nrestartsmax, std::v
 	}
 
 	// loop is complete
-	DoptimReturn a = {dds, AA, nrestarts, nrestarts};
+	DoptimReturn a = {OA_MOVE ( dds ), OA_MOVE ( AA ), nrestarts, nrestarts};
 	return a;
 }
 
@@ -166,7 +212,7 @@ DoptimReturn DoptimizeDebug ( const arraydata_t &arrayclass, int nrestartsmax, s
 	}
 
 	// loop is complete
-	DoptimReturn a = {dds, AA, nrestarts, nrestarts};
+	DoptimReturn a = {OA_MOVE ( dds ), OA_MOVE ( AA ), nrestarts, nrestarts};
 	return a;
 }
 
@@ -227,7 +273,7 @@ DoptimReturn DoptimizeMixed ( const arraylist_t &sols, const arraydata_t &arrayc
 
 		//#pragma omp critical
 		dds[i]=alu2.Defficiencies();
-		AA[i]=alu2;
+		AA[i]=OA_MOVE ( alu2 );
 
 		if ( score2>score0 ) {
 			if ( verbose>=2 )
@@ -247,12 +293,49 @@ DoptimReturn DoptimizeMixed ( const arraylist_t &sols, const arraydata_t &arrayc
 	}
 
 	// loop is complete
-	DoptimReturn a = {dds, AA, ( int ) nn, ( int ) nimproved};
+	DoptimReturn a = {OA_MOVE ( dds ), OA_MOVE ( AA ), ( int ) nn, ( int ) nimproved};
 	return a;
 }
 
 
-array_link  optimDeff ( const array_link &A0,  const arraydata_t &arrayclass, const std::vector<double> alpha, int verbose, int optimmethod, int niter, int nabort )
+/** @brief Balance a design with respect to the t-tuples of a frequency table
+ *
+ * Random swaps of two values inside a column are made and accepted with simulated annealing on the sum of squared
+ * deviations of the t-tuple counts from lambda. The temperature decreases linearly to zero in niter steps. Since
+ * swaps inside a column keep the columns balanced, the starting design should have strength 1.
+ *
+ * @return True if the design has the strength of the frequency table
+ */
+static bool balanceStrength ( array_link &A, strength_freqtable_t &freqtable, long niter, double temperature=2 )
+{
+	const int N = A.n_rows;
+	const int k = A.n_columns;
+	for ( long ii=0; ii<niter && freqtable.nbad>0; ii++ ) {
+		const int c = fastrandK ( k );
+		const int r = fastrandK ( N );
+		const int r2 = fastrandK ( N );
+		const array_t o = A._at ( r,c );
+		const array_t o2 = A._at ( r2,c );
+		if ( o==o2 )
+			continue;
+
+		const long sqdev = freqtable.sqdev;
+		freqtable.update ( A, r, c, o2 );
+		A._setvalue ( r,c,o2 );
+		freqtable.update ( A, r2, c, o );
+		A._setvalue ( r2,c,o );
+		const long delta = freqtable.sqdev-sqdev;
+		if ( delta>0 && fastrandK ( 32768 ) >= 32768*exp ( -delta/ ( temperature* ( 1-double ( ii ) /niter ) ) ) ) {
+			freqtable.update ( A, r2, c, o2 );
+			A._setvalue ( r2,c,o2 );
+			freqtable.update ( A, r, c, o );
+			A._setvalue ( r,c,o );
+		}
+	}
+	return freqtable.nbad==0;
+}
+
+array_link  optimDeff ( const array_link &A0,  const arraydata_t &arrayclass, const std::vector<double> alpha, int verbose, int optimmethod, int niter, int nabort, int strength )
 {
 	const int N = arrayclass.N;
 	const int k = arrayclass.ncols;
@@ -274,12 +357,36 @@ array_link  optimDeff ( const array_link &A0,  const arraydata_t &arrayclass, co
 		if ( arrayclass.is2level() )
 			optimmethod=DOPTIM_FLIP;
 	}
+	if ( strength>k )
+		strength=k;
+	if ( strength>0 ) {
+		// only swaps inside a column keep the columns balanced
+		optimmethod=DOPTIM_SWAP;
+	}
 	array_link A = A0;
 	symmetry_group sg=symmetry_group ( s );
 
+	const int nn = N*k;
+
+	// for strength 1 the swaps inside a column are sufficient, for higher strength we keep track of the t-tuples
+	strength_freqtable_t *freqtable = 0;
+	int nrejected=0;
+	if ( strength>=2 ) {
+		freqtable = new strength_freqtable_t ( arrayclass, strength );
+		freqtable->init_frequencies ( A );
+		if ( freqtable->nbad>0 ) {
+			// the rejection of moves only preserves the strength, so first make the initial design balanced
+			if ( ! balanceStrength ( A, *freqtable, 20000L*nn ) ) {
+				if ( verbose )
+					myprintf ( "optimDeff: could not generate a design with strength %d\n", strength );
+				niter=0;
+			}
+		}
+	}
+
 	std::vector<int> gidx = sg.gidx;
 
-	std::vector<double> dd0 = A0.Defficiencies();
+	std::vector<double> dd0 = A.Defficiencies();
 
 	if ( verbose ) {
 		myprintf ( "optimDeff: initial D-efficiency %.4f\n",  dd0[0] );
@@ -291,7 +398,6 @@ array_link  optimDeff ( const array_link &A0,  const arraydata_t &arrayclass, co
 	int lc=0;	// index of last change to array
 
 	// initialize arary with random permutation
-	const int nn = N*k;
 	std::vector<int> updatepos = permutation<int> ( nn );
 	my_random_shuffle ( updatepos.begin(), updatepos.end() );
 	int updateidx = 0;
@@ -299,6 +405,13 @@ array_link  optimDeff ( const array_link &A0,  const arraydata_t &arrayclass, co
 
 //#pragma omp for
 	for ( int ii=0; ii<niter; ii++ ) {
+		// check progress, moves that are skipped or rejected also count
+		if ( ( ii-lc ) >nabort ) {
+			if ( verbose>=2 )
+				myprintf ( "optimDeff: early abort ii %d, lc %d: %d\n", ii, lc, ( ii-lc ) );
+			break;
+		}
+
 		// select random row and column
 		int r = updatepos[updateidx] % N;
 		int c = updatepos[updateidx] / N;
@@ -310,6 +423,8 @@ array_link  optimDeff ( const array_link &A0,  const arraydata_t &arrayclass, co
 
 		// make sure column is proper column group
 		int c2 = sg.gstart[sg.gidx[c]] + fastrandK ( sg.gsize[gidx[c]] );
+		if ( strength>0 )
+			c2=c;
 
 		// get values
 		array_t o = A._at ( r,c );
@@ -322,6 +437,24 @@ array_link  optimDeff ( const array_link &A0,  const arraydata_t &arrayclass, co
 
 		switch ( optimmethod ) {
 		case DOPTIM_SWAP: // swap
+			if ( freqtable!=0 ) {
+				// the rows are different, so both updates can be made before changing the array
+				const int nbad = freqtable->nbad;
+				freqtable->update ( A, r, c, o2 );
+				freqtable->update ( A, r2, c2, o );
+				A._setvalue ( r,c,o2 );
+				A._setvalue ( r2,c2,o );
+				if ( freqtable->nbad>nbad ) {
+					// reject moves that break the strength before evaluating the design
+					freqtable->update ( A, r, c, o );
+					freqtable->update ( A, r2, c2, o2 );
+					A._setvalue ( r,c,o );
+					A._setvalue ( r2,c2,o2 );
+					nrejected++;
+					continue;
+				}
+				break;
+			}
 			A._setvalue ( r,c,o2 );
 			A._setvalue ( r2,c2,o );
 			break;
@@ -375,6 +508,10 @@ array_link  optimDeff ( const array_link &A0,  const arraydata_t &arrayclass, co
 			// restore to original
 			switch ( optimmethod ) {
 			case DOPTIM_SWAP:
+				if ( freqtable!=0 ) {
+					freqtable->update ( A, r, c, o );
+					freqtable->update ( A, r2, c2, o2 );
+				}
 				A._setvalue ( r,c,o );
 				A._setvalue ( r2,c2,o2 );
 				break;
@@ -386,15 +523,12 @@ array_link  optimDeff ( const array_link &A0,  const arraydata_t &arrayclass, co
 				break;
 			}
 		}
+	}
 
-		// check progress
-		if ( ( ii-lc ) >nabort ) {
-			if ( verbose>=2 )
-				myprintf ( "optimDeff: early abort ii %d, lc %d: %d\n", ii, lc, ( ii-lc ) );
-			//abort=true;
-			break;
-		}
-
+	if ( freqtable!=0 ) {
+		if ( verbose>=2 )
+			myprintf ( "optimDeff: rejected %d moves that break strength %d\n", nrejected, strength );
+		delete freqtable;
 	}
 
 	std::vector<double> dd = A.Defficiencies();
@@ -554,6 +688,284 @@ array_link  optimDeff2level ( const array_link &A0,  const arraydata_t &arraycla
 }
 
 #include <algorithm>
+#include <limits>
+
+/// return the order of the designs generated by Doptimize by decreasing score, the designs themselves are not copied
+static std::vector<int> sortDoptimResults ( const DoptimReturn &rr, const std::vector<double> &alpha )
+{
+	std::vector<double> sval ( rr.designs.size() );
+	for ( size_t i=0; i<rr.designs.size(); i++ ) {
+		sval[i]=-scoreD ( rr.dds[i], alpha );
+	}
+
+	indexsort sorter ( sval );
+	return sorter.indices;
+}
+
+#ifdef RPACKAGE
+#define R_NO_REMAP
+#include <Rinternals.h>
+
+/// return true if the argument is a non-empty R integer matrix, otherwise print an error message
+static bool isIntegerMatrix ( SEXP A, const char *name )
+{
+	if ( TYPEOF ( A ) !=INTSXP || ! Rf_isMatrix ( A ) ) {
+		myprintf ( "%s: input should be an integer matrix\n", name );
+		return false;
+	}
+	SEXP dim = Rf_getAttrib ( A, R_DimSymbol );
+	if ( INTEGER ( dim ) [0]<=0 || INTEGER ( dim ) [1]<=0 ) {
+		myprintf ( "%s: design should have at least one row and one column\n", name );
+		return false;
+	}
+	return true;
+}
+
+/// return the number of rows and columns of an R matrix
+static void matrixSize ( SEXP A, int &nrows, int &ncols )
+{
+	SEXP dim = Rf_getAttrib ( A, R_DimSymbol );
+	nrows = INTEGER ( dim ) [0];
+	ncols = INTEGER ( dim ) [1];
+}
+
+/** @brief Check the values of a design in an integer matrix, print an error message if they are invalid
+ *
+ * The factor levels should be coded as 0, 1, ..., s-1. Since a factor with more levels than rows cannot be balanced,
+ * the values should be smaller than the number of rows N. Missing values (NA) are not allowed.
+ */
+static bool checkDesignValues ( const int *data, int N, int k, const char *name )
+{
+	const long maxvalue = std::min ( ( long ) N-1, ( long ) std::numeric_limits<array_t>::max() );
+	const size_t n = ( size_t ) N*k;
+	for ( size_t i=0; i<n; i++ ) {
+		if ( data[i]==NA_INTEGER ) {
+			myprintf ( "%s: design contains missing values\n", name );
+			return false;
+		}
+		if ( data[i]<0 || data[i]>maxvalue ) {
+			myprintf ( "%s: design values should be in the range 0, ..., %ld, found value %d\n", name, maxvalue, data[i] );
+			return false;
+		}
+	}
+	return true;
+}
+
+/** @brief Collect the data of a batch of designs of equal size
+ *
+ * The designs are either a list of integer matrices or an integer array of size N x k x n. Designs without rows or
+ * columns are rejected. No data is copied, the pointers point into the R objects.
+ */
+static bool designBatch ( SEXP designs, std::vector<const int *> &data, int &N, int &k, const char *name )
+{
+	data.clear();
+	if ( TYPEOF ( designs ) ==INTSXP && Rf_isArray ( designs ) ) {
+		SEXP dim = Rf_getAttrib ( designs, R_DimSymbol );
+		if ( Rf_length ( dim ) ==3 ) {
+			N = INTEGER ( dim ) [0];
+			k = INTEGER ( dim ) [1];
+			const int n = INTEGER ( dim ) [2];
+			if ( N<=0 || k<=0 || n<0 || ( double ) N*k*n != ( double ) Rf_xlength ( designs ) ) {
+				myprintf ( "%s: invalid array of designs with dimensions %dx%dx%d\n", name, N, k, n );
+				return false;
+			}
+			for ( int i=0; i<n; i++ )
+				data.push_back ( INTEGER ( designs ) + ( size_t ) i*N*k );
+			return true;
+		}
+	}
+	if ( Rf_isNewList ( designs ) ) {
+		const int n = Rf_length ( designs );
+		N=0;
+		k=0;
+		for ( int i=0; i<n; i++ ) {
+			SEXP A = VECTOR_ELT ( designs, i );
+			if ( ! isIntegerMatrix ( A, name ) )
+				return false;
+			int Ni, ki;
+			matrixSize ( A, Ni, ki );
+			if ( i==0 ) {
+				N=Ni;
+				k=ki;
+			}
+			if ( Ni!=N || ki!=k ) {
+				myprintf ( "%s: design %d has size %dx%d, expected %dx%d\n", name, i+1, Ni, ki, N, k );
+				return false;
+			}
+			data.push_back ( INTEGER ( A ) );
+		}
+		return true;
+	}
+	myprintf ( "%s: input should be a list of integer matrices or a 3-dimensional integer array\n", name );
+	return false;
+}
+
+/** @brief Calculate a property for a batch of designs and return a matrix with one row per design
+ *
+ * The result matrix is allocated before the calculation, in the parallel loop no R functions are called.
+ * The Property class defines the R type of the result, the number of values per design and the calculation.
+ * The kernels report invalid input with myprintf, which calls R and may not be used in the parallel loop. The
+ * arguments of the property and the values of the designs are therefore checked before the loop.
+ */
+template <class Property>
+static SEXP designBatchProperty ( SEXP designs, const Property &property, const char *name )
+{
+	std::vector<const int *> data;
+	int N, k;
+	if ( ! designBatch ( designs, data, N, k, name ) )
+		return R_NilValue;
+	if ( ! property.check ( N, k, name ) )
+		return R_NilValue;
+
+	const long n = data.size();
+	for ( long i=0; i<n; i++ ) {
+		if ( ! checkDesignValues ( data[i], N, k, name ) )
+			return R_NilValue;
+	}
+	const int m = property.size ( N, k );
+	SEXP result = PROTECT ( Rf_allocMatrix ( Property::rtype, n, m ) );
+	typename Property::value_t *values = property.values ( result );
+
+#ifdef DOOPENMP
+	#pragma omp parallel for schedule(dynamic,16)
+#endif
+	for ( long i=0; i<n; i++ ) {
+		int32arrayview_t al ( data[i], N, k );
+		const std::vector<typename Property::value_t> v = property ( al.array() );
+		for ( int j=0; j<m; j++ )
+			values[i+n*j] = v[j];
+	}
+
+	UNPROTECT ( 1 );
+	return result;
+}
+
+/// D-, Ds- and D1-efficiency
+struct batchDefficiencies_t {
+	typedef double value_t;
+	static const SEXPTYPE rtype = REALSXP;
+	value_t *values ( SEXP result ) const {
+		return REAL ( result );
+	}
+	bool check ( int N, int k, const char *name ) const {
+		if ( N>500 || k>500 ) {
+			myprintf ( "%s: array size %dx%d not supported, the maximum size is 500x500\n", name, N, k );
+			return false;
+		}
+		return true;
+	}
+	int size ( int, int ) const {
+		return 3;
+	}
+	std::vector<value_t> operator() ( const array_link &al ) const {
+		return al.Defficiencies();
+	}
+};
+
+/// generalized wordlength pattern (A_0, ..., A_k)
+struct batchGWLP_t {
+	typedef double value_t;
+	static const SEXPTYPE rtype = REALSXP;
+	int truncate;
+	batchGWLP_t ( int truncate_ ) : truncate ( truncate_ ) {}
+	value_t *values ( SEXP result ) const {
+		return REAL ( result );
+	}
+	bool check ( int, int, const char * ) const {
+		return true;
+	}
+	int size ( int, int k ) const {
+		return k+1;
+	}
+	std::vector<value_t> operator() ( const array_link &al ) const {
+		std::vector<double> gwlp = GWLP ( al, 0, truncate );
+		gwlp.resize ( al.n_columns+1 );
+		return gwlp;
+	}
+};
+
+/// J-characteristics of all combinations of jj columns
+struct batchJcharacteristics_t {
+	typedef int value_t;
+	static const SEXPTYPE rtype = INTSXP;
+	int jj;
+	batchJcharacteristics_t ( int jj_ ) : jj ( jj_ ) {}
+	value_t *values ( SEXP result ) const {
+		return INTEGER ( result );
+	}
+	bool check ( int, int k, const char *name ) const {
+		if ( jj<1 || jj>20 ) {
+			myprintf ( "%s: J-characteristics are only supported for 1 <= jj <= 20\n", name );
+			return false;
+		}
+		if ( jj<=k && ncombsm<double> ( k, jj ) >1e8 ) {
+			myprintf ( "%s: number of combinations of %d out of %d columns is too large\n", name, jj, k );
+			return false;
+		}
+		return true;
+	}
+	int size ( int, int k ) const {
+		return ( jj>k ) ? 0 : ncombsm<long> ( k, jj );
+	}
+	std::vector<value_t> operator() ( const array_link &al ) const {
+		return Jcharacteristics ( al, jj );
+	}
+};
+
+/// strength
+struct batchStrength_t {
+	typedef int value_t;
+	static const SEXPTYPE rtype = INTSXP;
+	value_t *values ( SEXP result ) const {
+		return INTEGER ( result );
+	}
+	bool check ( int, int, const char * ) const {
+		return true;
+	}
+	int size ( int, int ) const {
+		return 1;
+	}
+	std::vector<value_t> operator() ( const array_link &al ) const {
+		return std::vector<value_t> ( 1, al.strength() );
+	}
+};
+
+/// centered L2-discrepancy
+struct batchCL2discrepancy_t {
+	typedef double value_t;
+	static const SEXPTYPE rtype = REALSXP;
+	value_t *values ( SEXP result ) const {
+		return REAL ( result );
+	}
+	bool check ( int, int, const char * ) const {
+		return true;
+	}
+	int size ( int, int ) const {
+		return 1;
+	}
+	std::vector<value_t> operator() ( const array_link &al ) const {
+		return std::vector<value_t> ( 1, CL2discrepancy ( al ) );
+	}
+};
+
+/// VIF-efficiency
+struct batchVIFefficiency_t {
+	typedef double value_t;
+	static const SEXPTYPE rtype = REALSXP;
+	value_t *values ( SEXP result ) const {
+		return REAL ( result );
+	}
+	bool check ( int, int, const char * ) const {
+		return true;
+	}
+	int size ( int, int ) const {
+		return 1;
+	}
+	std::vector<value_t> operator() ( const array_link &al ) const {
+		return std::vector<value_t> ( 1, VIFefficiency ( al ) );
+	}
+};
+#endif
 
 extern "C" {
 
@@ -579,11 +991,6 @@ extern "C" {
 		int k = *pk;
 		int verbose = *_verbose;
 
-		output[0]=1;
-		output[1]=2;
-		output[2]=3;
-		output[3]=4;
-
 		if ( verbose>=2 )
 			myprintf ( "DoptimizeR: N %d, k %d, nrestarts %d, niter %d, alpha1 %f\n", N, k, *nrestarts, niter, *alpha1 );
 
@@ -595,21 +1002,10 @@ extern "C" {
 
 		DoptimReturn rr = Doptimize ( arrayclass, *nrestarts, alpha,  verbose,  method, niter, *maxtime,  *nabort );
 
-		std::vector<std::vector<double> > dds = rr.dds;
-		arraylist_t AA = rr.designs;
-
 		// sort according to values
-		std::vector<double> sval ( AA.size() );
-		for ( size_t i=0; i<AA.size(); i++ ) {
-			sval[i]=-scoreD ( dds[i], alpha );
-		}
-
-		indexsort sorter ( sval );
+		std::vector<int> order = sortDoptimResults ( rr, alpha );
 
-		AA=sorter.sorted ( AA );
-		dds=sorter.sorted ( dds );
-
-		array_link best = AA[0];
+		const array_link &best = rr.designs[order[0]];
 std::vector<double> dd = best.Defficiencies();
 
 		std::copy ( best.array, best.array+N*k, output );
@@ -626,6 +1022,169 @@ std::vector<double> dd = best.Defficiencies();
 
 	}
 
+#ifdef RPACKAGE
+	/** @brief Interface for .Call: generate optimal designs and return all designs with their efficiencies
+	 *
+	 * The result is a list with an integer array of size N x k x K containing the designs and a K x 3 matrix with the
+	 * D-, Ds- and D1-efficiencies. The designs are sorted by decreasing score. The result is allocated once in R memory
+	 * and every design is copied into it once, in sorted order.
+	 *
+	 * @param alpha Vector with the 3 parameters of the optimization function
+	 * @param ndesigns Maximum number of designs K to return, if negative all designs are returned
+	 * @param strength If positive, only designs with this strength are generated
+	 */
+	SEXP DoptimizeCall ( SEXP pN, SEXP pk, SEXP pnrestarts, SEXP palpha, SEXP pverbose, SEXP pmethod, SEXP pniter, SEXP pmaxtime, SEXP pnabort, SEXP pndesigns, SEXP pstrength )
+	{
+		const int N = Rf_asInteger ( pN );
+		const int k = Rf_asInteger ( pk );
+		const int nrestarts = Rf_asInteger ( pnrestarts );
+		const int verbose = Rf_asInteger ( pverbose );
+		const int ndesigns = Rf_asInteger ( pndesigns );
+
+		if ( N<=0 || k<=0 || nrestarts<=0 || TYPEOF ( palpha ) !=REALSXP || Rf_length ( palpha ) !=3 ) {
+			myprintf ( "DoptimizeCall: invalid arguments\n" );
+			return R_NilValue;
+		}
+
+		std::vector<double> alpha ( 3 );
+		for ( int i=0; i<3; i++ )
+			alpha[i]=std::max ( REAL ( palpha ) [i], 0. );
+
+		arraydata_t arrayclass ( 2, N, 0, k );
+		DoptimReturn rr = Doptimize ( arrayclass, nrestarts, alpha, verbose, Rf_asInteger ( pmethod ), Rf_asInteger ( pniter ), Rf_asReal ( pmaxtime ), Rf_asInteger ( pnabort ), Rf_asInteger ( pstrength ) );
+		std::vector<int> order = sortDoptimResults ( rr, alpha );
+
+		int K = rr.designs.size();
+		if ( ndesigns>=0 && ndesigns<K )
+			K=ndesigns;
+
+		SEXP designs = PROTECT ( Rf_alloc3DArray ( INTSXP, N, k, K ) );
+		int *d = INTEGER ( designs );
+		for ( int i=0; i<K; i++ ) {
+			const array_link &al = rr.designs[order[i]];
+			std::copy ( al.array, al.array+N*k, d+ ( size_t ) i*N*k );
+		}
+
+		SEXP scores = PROTECT ( Rf_allocMatrix ( REALSXP, K, 3 ) );
+		double *s = REAL ( scores );
+		for ( int i=0; i<K; i++ )
+			for ( int j=0; j<3; j++ )
+				s[i+K*j] = rr.dds[order[i]][j];
+
+		SEXP result = PROTECT ( Rf_allocVector ( VECSXP, 2 ) );
+		SET_VECTOR_ELT ( result, 0, designs );
+		SET_VECTOR_ELT ( result, 1, scores );
+		SEXP names = PROTECT ( Rf_allocVector ( STRSXP, 2 ) );
+		SET_STRING_ELT ( names, 0, Rf_mkChar ( "designs" ) );
+		SET_STRING_ELT ( names, 1, Rf_mkChar ( "scores" ) );
+		Rf_setAttrib ( result, R_NamesSymbol, names );
+
+		if ( verbose>=2 )
+			myprintf ( "DoptimizeCall: returning %d designs\n", K );
+
+		UNPROTECT ( 4 );
+		return result;
+	}
+
+	/// Interface for .Call: return the D-, Ds- and D1-efficiency of a design in an integer matrix
+	SEXP DefficienciesCall ( SEXP A )
+	{
+		if ( ! isIntegerMatrix ( A, "DefficienciesCall" ) )
+			return R_NilValue;
+		int N, k;
+		matrixSize ( A, N, k );
+		if ( ! checkDesignValues ( INTEGER ( A ), N, k, "DefficienciesCall" ) )
+			return R_NilValue;
+		SEXP result = PROTECT ( Rf_allocVector ( REALSXP, 3 ) );
+		{
+			int32arrayview_t al ( INTEGER ( A ), N, k );
+			std::vector<double> dd = al.array().Defficiencies();
+			std::copy ( dd.begin(), dd.begin() +3, REAL ( result ) );
+		}
+		UNPROTECT ( 1 );
+		return result;
+	}
+
+	/// Interface for .Call: return the GWLP of a design in an integer matrix
+	SEXP GWLPCall ( SEXP A, SEXP truncate )
+	{
+		if ( ! isIntegerMatrix ( A, "GWLPCall" ) )
+			return R_NilValue;
+		int N, k;
+		matrixSize ( A, N, k );
+		if ( ! checkDesignValues ( INTEGER ( A ), N, k, "GWLPCall" ) )
+			return R_NilValue;
+		SEXP result = PROTECT ( Rf_allocVector ( REALSXP, k+1 ) );
+		{
+			int32arrayview_t al ( INTEGER ( A ), N, k );
+			std::vector<double> gwlp = GWLP ( al.array(), 0, Rf_asInteger ( truncate ) );
+			gwlp.resize ( k+1 );
+			std::copy ( gwlp.begin(), gwlp.end(), REAL ( result ) );
+		}
+		UNPROTECT ( 1 );
+		return result;
+	}
+
+	/// Interface for .Call: return the strength of a design in an integer matrix
+	SEXP strengthCall ( SEXP A )
+	{
+		if ( ! isIntegerMatrix ( A, "strengthCall" ) )
+			return R_NilValue;
+		int N, k;
+		matrixSize ( A, N, k );
+		if ( ! checkDesignValues ( INTEGER ( A ), N, k, "strengthCall" ) )
+			return R_NilValue;
+		SEXP result = PROTECT ( Rf_allocVector ( INTSXP, 1 ) );
+		{
+			int32arrayview_t al ( INTEGER ( A ), N, k );
+			INTEGER ( result ) [0] = al.array().strength();
+		}
+		UNPROTECT ( 1 );
+		return result;
+	}
+
+	/** @brief Interfaces for .Call: calculate a property for a batch of designs
+	 *
+	 * The designs are passed as a list of integer matrices or as an integer array of size N x k x n. All designs
+	 * should have the same size. The designs are evaluated in parallel and the result is a matrix with one row
+	 * per design.
+	 */
+	SEXP DefficienciesBatchCall ( SEXP designs )
+	{
+		return designBatchProperty ( designs, batchDefficiencies_t(), "DefficienciesBatchCall" );
+	}
+
+	/// Interface for .Call: return a n x (k+1) matrix with the GWLPs of a batch of designs
+	SEXP GWLPBatchCall ( SEXP designs, SEXP truncate )
+	{
+		return designBatchProperty ( designs, batchGWLP_t ( Rf_asInteger ( truncate ) ), "GWLPBatchCall" );
+	}
+
+	/// Interface for .Call: return a matrix with the J-characteristics of all combinations of jj columns for a batch of designs
+	SEXP JcharacteristicsBatchCall ( SEXP designs, SEXP jj )
+	{
+		return designBatchProperty ( designs, batchJcharacteristics_t ( Rf_asInteger ( jj ) ), "JcharacteristicsBatchCall" );
+	}
+
+	/// Interface for .Call: return the strengths of a batch of designs
+	SEXP strengthBatchCall ( SEXP designs )
+	{
+		return designBatchProperty ( designs, batchStrength_t(), "strengthBatchCall" );
+	}
+
+	/// Interface for .Call: return the centered L2-discrepancies of a batch of designs
+	SEXP CL2discrepancyBatchCall ( SEXP designs )
+	{
+		return designBatchProperty ( designs, batchCL2discrepancy_t(), "CL2discrepancyBatchCall" );
+	}
+
+	/// Interface for .Call: return the VIF-efficiencies of a batch of designs
+	SEXP VIFefficiencyBatchCall ( SEXP designs )
+	{
+		return designBatchProperty ( designs, batchVIFefficiency_t(), "VIFefficiencyBatchCall" );
+	}
+#endif
+
 } // extern "C"
 
 // kate: indent-mode cstyle; indent-width 4; replace-tabs off; tab-width 4; 
@@ -21,8 +21,13 @@ enum {DOPTIM_UPDATE, DOPTIM_SWAP, DOPTIM_FLIP, DOPTIM_AUTOMATIC, DOPTIM_NONE};
  * 	arrayclass: structure describing the design class
  * 	alpha: (3x1 array)
  * 	verbose: output level
+ * 	strength: if positive, the design is kept at this strength. Only swaps inside a column are used, so the initial
+ * 	design should have strength 1. For strength 2 or higher the initial design is first balanced with swaps inside
+ * 	the columns (simulated annealing on the deviations of the t-tuple counts), then swaps that break the strength are
+ * 	rejected before the design is evaluated. If no balanced design is found, the design is returned without
+ * 	optimization
  */
-array_link  optimDeff ( const array_link &A0,  const arraydata_t &arrayclass, std::vector<double> alpha, int verbose=1, int optimmethod = DOPTIM_AUTOMATIC, int niter=100000, int nabort=0 );
+array_link  optimDeff ( const array_link &A0,  const arraydata_t &arrayclass, std::vector<double> alpha, int verbose=1, int optimmethod = DOPTIM_AUTOMATIC, int niter=100000, int nabort=0, int strength=0 );
 
 /// debugging function
 array_link  optimDeff2level ( const array_link &A0,  const arraydata_t &arrayclass,  std::vector<double> alpha, int verbose=1, int optimmethod= DOPTIM_AUTOMATIC, int niter=100000, int nabort = 0 );
@@ -41,8 +46,14 @@ struct DoptimReturn {
 };
 
 
-/// function to generate optimal designs
-DoptimReturn Doptimize ( const arraydata_t &arrayclass, int nrestarts, const std::vector<double> alpha, int verbose, int method = DOPTIM_AUTOMATIC, int niter = 300000, double maxtime = 100000, int nabort=5000 );
+/** @brief Function to generate optimal designs
+ *
+ * For strength>0 the designs are optimized with the given strength, see optimDeff, and designs that do not have the
+ * strength are not stored. If the number of runs is not a multiple of the number of level combinations of every t
+ * columns, no design with the strength exists and an empty result is returned without optimization.
+ * If dedupe is true, designs that are identical to a design found earlier are not stored.
+ */
+DoptimReturn Doptimize ( const arraydata_t &arrayclass, int nrestarts, const std::vector<double> alpha, int verbose, int method = DOPTIM_AUTOMATIC, int niter = 300000, double maxtime = 100000, int nabort=5000, int strength=0, int dedupe=0 );
 DoptimReturn DoptimizeDebug ( const arraydata_t &arrayclass, int nrestarts, const std::vector<double> alpha, int verbose, int method = DOPTIM_AUTOMATIC, int niter = 300000, double maxtime = 100000, int nabort=5000 );
 
 DoptimReturn DoptimizeMixed(const arraylist_t &sols, const arraydata_t &arrayclass, const std::vector<double> alpha, int verbose=1, int nabort=-1);
@@ -472,8 +472,244 @@ std::vector<double> macwilliams_transform_mixed ( const ndarray<double> &B, cons
 }
 
 #ifdef FULLPACKAGE
+/** @brief Cholesky factorization of the information matrices of projection designs
+ *
+ * For a two-level design the information matrix of a projection design is a principal submatrix of the information
+ * matrix of the second order model for all factors. The factors of a projection are added one at a time: adding the
+ * factor at position d appends the main effect and the interactions with the factors at positions 0, ..., d-1 to the
+ * Cholesky factor (bordered Cholesky update). When consecutive projections share their first factors, only the blocks
+ * for the changed factors are recalculated.
+ */
+class projection_cholesky_t
+{
+public:
+	/// number of factors in the projection
+	const int kp;
+	/// number of parameters of the projection model
+	const int m;
+
+	projection_cholesky_t ( const Eigen::MatrixXd &gram, int N, int k, int kp ) : kp ( kp ), m ( 1 + kp + kp* ( kp-1 ) /2 ), gram ( gram ), N ( N ), k ( k ), L ( Eigen::MatrixXd::Zero ( m, m ) ), colidx ( m ), factors ( kp ), ngood ( 0 ) {
+		colidx[0]=0;
+		L ( 0,0 ) = sqrt ( gram ( 0,0 ) );
+	}
+
+	/** @brief Return true if the information matrix of the projection onto the specified factors is non-singular
+	 *
+	 * The factorization of the factors before position start is re-used from the previous call. The factorization
+	 * is not pivoted, since the order of the columns is fixed by the re-use, and stops at the first pivot that is zero
+	 * relative to the diagonal element of the information matrix.
+	 */
+	bool fullrank ( const int *comb, int start ) {
+		if ( ngood<start ) {
+			// the unchanged factors already give a singular information matrix
+			std::copy ( comb, comb+kp, factors.begin() );
+			return false;
+		}
+		for ( int d=start; d<kp; d++ ) {
+			factors[d]=comb[d];
+			if ( ! addblock ( d ) ) {
+				ngood=d;
+				std::copy ( comb+d, comb+kp, factors.begin() +d );
+				return false;
+			}
+		}
+		ngood=kp;
+		return true;
+	}
+
+	/// Return the D-efficiency of the projection onto the specified factors
+	double Defficiency ( const int *comb, int start ) {
+		if ( ! fullrank ( comb, start ) )
+			return 0;
+
+		double logdet=0;
+		for ( int i=0; i<m; i++ )
+			logdet += log ( L ( i,i ) );
+		double D = exp ( 2*logdet/m ) /N;
+		return std::min ( D, 1. );
+	}
+
+private:
+	const Eigen::MatrixXd &gram;
+	const int N;
+	const int k;
+	Eigen::MatrixXd L;
+	std::vector<int> colidx;
+	std::vector<int> factors;
+	/// number of positions for which the factorization is valid
+	int ngood;
+
+	/// index in the second order model matrix of the interaction between factors a and b
+	int interactionindex ( int a, int b ) const {
+		if ( a<b )
+			std::swap ( a,b );
+		return 1+k+a* ( a-1 ) /2+b;
+	}
+
+	/// add the block of the factor at position d, return false if the information matrix is singular
+	bool addblock ( int d ) {
+		const int b0 = 1+d+d* ( d-1 ) /2;
+		const int f = factors[d];
+		colidx[b0] = 1+f;
+		for ( int j=0; j<d; j++ )
+			colidx[b0+1+j] = interactionindex ( f, factors[j] );
+
+		for ( int p=b0; p<b0+1+d; p++ ) {
+			const int cp = colidx[p];
+			for ( int q=0; q<p; q++ ) {
+				double v = gram ( cp, colidx[q] );
+				for ( int j=0; j<q; j++ )
+					v -= L ( p,j ) *L ( q,j );
+				L ( p,q ) = v/L ( q,q );
+			}
+			const double diag = gram ( cp, cp );
+			double v = diag;
+			for ( int j=0; j<p; j++ )
+				v -= L ( p,j ) *L ( p,j );
+			if ( v<=1e-10*diag )
+				return false;
+			L ( p,p ) = sqrt ( v );
+		}
+		return true;
+	}
+};
+
+/// return the combination with the specified rank in lexicographic order
+static void unrank_comb ( int64_t rank, int *comb, int kp, int k )
+{
+	int c=0;
+	for ( int pos=0; pos<kp; pos++ ) {
+		while ( true ) {
+			int64_t n = ncombsm<int64_t> ( k-1-c, kp-1-pos );
+			if ( rank<n )
+				break;
+			rank -= n;
+			c++;
+		}
+		comb[pos]=c;
+		c++;
+	}
+}
+
+Eigen::MatrixXd secondOrderInformationMatrix ( const packedarray_t &pa )
+{
+	const int N = pa.n_rows;
+	const int k = pa.n_columns;
+	const int nw = pa.nw;
+	const int m = 1 + k + k* ( k-1 ) /2;
+
+	// bit vectors of the columns of the model matrix, a set bit corresponds to the value +1
+	std::vector<unsigned long long> x ( ( size_t ) m*nw, 0 );
+	for ( int r=0; r<N; r++ )
+		x[r/64] |= 1ULL << ( r%64 );
+	std::copy ( pa.words.begin(), pa.words.end(), x.begin() +nw );
+	int ww=k+1;
+	for ( int c=0; c<k; ++c ) {
+		for ( int c2=0; c2<c; ++c2 ) {
+			const unsigned long long *a = pa.column ( c );
+			const unsigned long long *b = pa.column ( c2 );
+			unsigned long long *p = &x[ ( size_t ) ww*nw];
+			for ( int w=0; w<nw; w++ )
+				p[w] = a[w] ^ b[w];
+			ww++;
+		}
+	}
+
+	Eigen::MatrixXd gram ( m, m );
+#ifdef DOOPENMP
+	#pragma omp parallel for schedule(dynamic) if(m>64)
+#endif
+	for ( int u=0; u<m; u++ ) {
+		const unsigned long long *xu = &x[ ( size_t ) u*nw];
+		for ( int v=0; v<=u; v++ ) {
+			const unsigned long long *xv = &x[ ( size_t ) v*nw];
+			int nd=0;
+			for ( int w=0; w<nw; w++ )
+				nd += popcount64 ( xu[w] ^ xv[w] );
+			gram ( u, v ) = N-2*nd;
+			gram ( v, u ) = gram ( u, v );
+		}
+	}
+	return gram;
+}
+
+/// information matrix of the second order model of a two-level design
+static Eigen::MatrixXd secondOrderInformationMatrix ( const array_link &al )
+{
+	return secondOrderInformationMatrix ( packedarray_t ( al ) );
+}
+
+/** @brief Calculate the D-efficiencies of a range of projection designs of a two-level design
+ *
+ * @param gram Information matrix of the second order model for all factors
+ * @param i0 Index of the first projection in lexicographic order
+ * @param i1 Index after the last projection
+ * @param dd If not zero, the D-efficiency of projection i is stored at dd[i]
+ * @param rankonly If true, only determine whether the projections are estimable and store 1 or 0 in dd
+ * @return Number of projections with a non-singular information matrix
+ */
+static int64_t projDeffRange ( const Eigen::MatrixXd &gram, int N, int kk, int kp, int64_t i0, int64_t i1, double *dd, int rankonly, int verbose )
+{
+	projection_cholesky_t chol ( gram, N, kk, kp );
+	std::vector<int> cp ( kp );
+	std::vector<int> prev ( kp );
+
+	int64_t nestimable=0;
+	unrank_comb ( i0, &cp[0], kp, kk );
+	int start=0;
+	for ( int64_t i=i0; i<i1; i++ ) {
+		double D = rankonly ? chol.fullrank ( &cp[0], start ) : chol.Defficiency ( &cp[0], start );
+		nestimable += D>0;
+		if ( dd!=0 )
+			dd[i]=D;
+
+		if ( verbose>=2 )
+			myprintf ( "projDeff: k %d, kp %d: i %ld, D %f\n", kk, kp, ( long ) i, D );
+
+		prev=cp;
+		next_comb ( cp, kp, kk );
+		start=0;
+		while ( start<kp && cp[start]==prev[start] )
+			start++;
+	}
+	return nestimable;
+}
+
+/** @brief Calculate the D-efficiencies for all projection designs of a two-level design
+ *
+ * The projections are processed in ranges of consecutive combinations, the ranges are distributed over the threads.
+ *
+ * @param dd If not zero, the D-efficiencies are stored in this array of size C(k, kp)
+ * @param rankonly If true, only determine whether the projections are estimable and store 1 or 0 in dd
+ * @return Number of projections with a non-singular information matrix
+ */
+static int64_t projDeffRanges ( const Eigen::MatrixXd &gram, int N, int kk, int kp, double *dd, int rankonly, int verbose )
+{
+	const int64_t ncomb = ncombsm<int64_t> ( kk, kp );
+	const int m = 1 + kp + kp* ( kp-1 ) /2;
+	if ( m>N || kp==0 ) {
+		if ( dd!=0 )
+			std::fill ( dd, dd+ncomb, 0 );
+		return 0;
+	}
+
+	const int64_t chunksize = 2048;
+	const int64_t nchunks = ( ncomb+chunksize-1 ) /chunksize;
+
+	int64_t nestimable=0;
+#ifdef DOOPENMP
+	#pragma omp parallel for schedule(dynamic,1) reduction(+:nestimable)
+#endif
+	for ( int64_t chunk=0; chunk<nchunks; chunk++ ) {
+		const int64_t i0 = chunk*chunksize;
+		const int64_t i1 = std::min ( i0+chunksize, ncomb );
+		nestimable += projDeffRange ( gram, N, kk, kp, i0, i1, dd, rankonly, verbose );
+	}
+	return nestimable;
+}
+
 /** Calculate D-efficiencies for all projection designs */
-std::vector<double> projDeff ( const array_link &al, int kp, int verbose=0 )
+std::vector<double> projDeff ( const array_link &al, int kp, int verbose, int rankonly )
 {
 
 	int kk = al.n_columns;
@@ -483,15 +719,22 @@ std::vector<double> projDeff ( const array_link &al, int kp, int verbose=0 )
 		cp[i]=i;
 	int64_t ncomb = ncombsm<int64_t> ( kk, kp );
 
-	std::vector<double> dd ( ncomb );
-
 	int m = 1 + kp + kp* ( kp-1 ) /2;
 	int N = al.n_rows;
 
 	if ( verbose )
 		myprintf ( "projDeff: k %d, kp %d: start with %ld combinations \n", kk, kp, ( long ) ncomb );
 
-//#pragma omp parallel for
+	if ( al.is2level() ) {
+		std::vector<double> dd ( ncomb );
+		projDeffRanges ( secondOrderInformationMatrix ( al ), N, kk, kp, ncomb>0? &dd[0]: 0, rankonly, verbose );
+		if ( verbose )
+			myprintf ( "projDeff: k %d, kp %d: done\n", kk, kp );
+		return dd;
+	}
+
+	std::vector<double> dd ( ncomb );
+
 	for ( int64_t i=0; i<ncomb; i++ ) {
 
 		array_link alsub = al.selectColumns ( cp );
@@ -499,6 +742,8 @@ std::vector<double> projDeff ( const array_link &al, int kp, int verbose=0 )
 			dd[i]=0;
 		else
 			dd[i] = alsub.Defficiency();
+		if ( rankonly )
+			dd[i] = dd[i]>0;
 
 		if ( verbose>=2 )
 			myprintf ( "projDeff: k %d, kp %d: i %ld, D %f\n", kk, kp, ( long ) i, dd[i] );
@@ -527,24 +772,23 @@ std::vector<double> PECsequence ( const array_link &al, int verbose )
 	int kk = al.n_columns;
 	std::vector<double> pec ( kk );
 
-	if ( kk>=20 ) {
-		myprintf ( "PECsequence: error: not defined for 20 or more columns\n" );
-		pec[0]=-1;
-		return pec;
-	}
-
+	// for two-level designs the estimable projections are counted without storing the D-efficiencies
+	Eigen::MatrixXd gram;
+	if ( al.is2level() )
+		gram = secondOrderInformationMatrix ( al );
 
-#ifdef DOOPENMP
-	#pragma omp parallel for
-#endif
 	for ( int i=0; i<kk; i++ ) {
 		int kp = i+1;
 		int m = 1 + kp + kp* ( kp-1 ) /2;
 
 		if ( m>N ) {
 			pec[i]=0;
+		} else if ( al.is2level() ) {
+			const int64_t ncomb = ncombsm<int64_t> ( kk, kp );
+			const int64_t nestimable = projDeffRanges ( gram, N, kk, kp, 0, 1, verbose>=2 );
+			pec[i] = double ( nestimable ) /ncomb;
 		} else {
-			std::vector<double> dd = projDeff ( al, kp, verbose>=2 );
+			std::vector<double> dd = projDeff ( al, kp, verbose>=2, 1 );
 
 			double ec=0;
 			for ( unsigned long j=0; j<dd.size(); j++ )
@@ -554,10 +798,85 @@ std::vector<double> PECsequence ( const array_link &al, int verbose )
 
 			pec[i]=ec;
 		}
+		if ( verbose )
+			myprintf ( "PECsequence: kp %d: %.4f\n", kp, pec[i] );
 	}
 
 	return pec;
 }
+
+pec_estimate_t PECsequenceMC ( const array_link &al, long nsamples, double maxtime, int verbose )
+{
+	const int N = al.n_rows;
+	const int kk = al.n_columns;
+
+	pec_estimate_t result;
+	if ( nsamples<=0 ) {
+		myprintf ( "PECsequenceMC: error: number of samples should be positive\n" );
+		return result;
+	}
+	result.pec.resize ( kk );
+	result.lower.resize ( kk );
+	result.upper.resize ( kk );
+	result.nsamples.resize ( kk );
+
+	if ( ! al.is2level() ) {
+		myprintf ( "PECsequenceMC: error: only implemented for two-level designs\n" );
+		if ( kk>0 )
+			result.pec[0]=-1;
+		return result;
+	}
+
+	const Eigen::MatrixXd gram = secondOrderInformationMatrix ( al );
+	const double z = 1.96;	// 95% confidence interval
+	const double tstart = get_time_ms();
+
+	for ( int i=0; i<kk; i++ ) {
+		const int kp = i+1;
+		const int m = 1 + kp + kp* ( kp-1 ) /2;
+		const int64_t ncomb = ncombsm<int64_t> ( kk, kp );
+
+		if ( m>N || ncomb<=nsamples ) {
+			// the exact value is cheap
+			const int64_t nestimable = projDeffRanges ( gram, N, kk, kp, 0, 1, 0 );
+			result.pec[i] = double ( nestimable ) /ncomb;
+			result.lower[i] = result.pec[i];
+			result.upper[i] = result.pec[i];
+			result.nsamples[i] = ncomb;
+			continue;
+		}
+
+		// sample random projections, the remaining time budget is divided over the remaining values of kp
+		const double t0 = get_time_ms();
+		const double budget = ( maxtime-get_time_ms ( tstart ) ) / ( kk-i );
+		projection_cholesky_t chol ( gram, N, kk, kp );
+		std::vector<int> perm = permutation<int> ( kk );
+		long n=0, nestimable=0;
+		for ( n=0; n<nsamples; n++ ) {
+			if ( n%256==0 && n>0 && get_time_ms ( t0 ) >budget )
+				break;
+			// partial Fisher-Yates shuffle
+			for ( int j=0; j<kp; j++ )
+				std::swap ( perm[j], perm[j+fastrandK ( kk-j )] );
+			nestimable += chol.fullrank ( &perm[0], 0 );
+		}
+
+		// Wilson score interval
+		const double p = double ( nestimable ) /n;
+		const double denom = 1+z*z/n;
+		const double centre = ( p+z*z/ ( 2*n ) ) /denom;
+		const double halfwidth = z*sqrt ( p* ( 1-p ) /n+z*z/ ( 4.*n*n ) ) /denom;
+		result.pec[i] = p;
+		result.lower[i] = std::max ( centre-halfwidth, 0. );
+		result.upper[i] = std::min ( centre+halfwidth, 1. );
+		result.nsamples[i] = n;
+
+		if ( verbose )
+			myprintf ( "PECsequenceMC: kp %d: %.4f [%.4f, %.4f] (%ld samples)\n", kp, p, result.lower[i], result.upper[i], n );
+	}
+
+	return result;
+}
 #endif
 
 
@@ -665,6 +984,48 @@ std::vector<double> GWLP ( const array_link &al, int verbose, int truncate )
 	}
 }
 
+std::vector<double> GWLP ( const packedarray_t &pa, int truncate )
+{
+	const int N = pa.n_rows;
+	const int n = pa.n_columns;
+	const int nwr = ( n+63 ) /64;
+
+	// pack the rows, the Hamming distance between two rows is then a popcount
+	std::vector<unsigned long long> rows ( ( size_t ) N*nwr, 0 );
+	for ( int c=0; c<n; c++ ) {
+		const unsigned long long *col = pa.column ( c );
+		for ( int r=0; r<N; r++ )
+			rows[ ( size_t ) r*nwr+c/64] |= ( ( col[r/64] >> ( r%64 ) ) & 1ULL ) << ( c%64 );
+	}
+
+	// calculate distance distribution
+	std::vector<long> dd ( n+1, 0 );
+	for ( int r1=0; r1<N; r1++ ) {
+		const unsigned long long *x1 = &rows[ ( size_t ) r1*nwr];
+		for ( int r2=0; r2<r1; r2++ ) {
+			const unsigned long long *x2 = &rows[ ( size_t ) r2*nwr];
+			int dh=0;
+			for ( int w=0; w<nwr; w++ )
+				dh += popcount64 ( x1[w] ^ x2[w] );
+			dd[dh]+=2;	// factor 2: dH is symmetric
+		}
+	}
+	dd[0] += N;
+	std::vector<double> B ( n+1 );
+	for ( int x=0; x<=n; x++ )
+		B[x] = double ( dd[x] ) /N;
+
+	std::vector<double> gma = macwilliams_transform ( B, N, 2 );
+	if ( truncate ) {
+		for ( size_t i=0; i<gma.size(); i++ ) {
+			gma[i]=round ( N*N*gma[i] ) / ( N*N );
+			if ( gma[i]==0 )
+				gma[i]=0;	 // fix minus zero
+		}
+	}
+	return gma;
+}
+
 /// convert GWLP sequence to unique value
 inline double GWPL2val ( GWLPvalue x )
 {
@@ -734,6 +1095,78 @@ std::vector<double> projectionGWLPvalues ( const array_link &al )
 	return v;
 }
 
+/// add a value to a hash, the value is rounded so that rounding errors in the calculation do not change the hash
+static inline unsigned long long fingerprintcombine ( unsigned long long h, double value )
+{
+	const long long x = ( long long ) floor ( value*1e8+.5 );
+	return fmix64 ( h ^ ( unsigned long long ) x ) + 0x9e3779b97f4a7c15ULL;
+}
+
+unsigned long long isomorphismFingerprint ( const array_link &al )
+{
+	unsigned long long h = fmix64 ( ( ( unsigned long long ) al.n_rows << 32 ) ^ ( unsigned long long ) al.n_columns );
+
+	// the GWLP is invariant under row, column and level permutations
+	std::vector<double> gwlp = GWLP ( al );
+	for ( size_t i=0; i<gwlp.size(); i++ )
+		h = fingerprintcombine ( h, gwlp[i] );
+
+	// the projection GWLPs are permuted by column permutations
+	const int ncols=al.n_columns;
+	std::vector<std::vector<double> > pgwlp ( ncols );
+	for ( int i=0; i<ncols; i++ )
+		pgwlp[i] = GWLP ( al.deleteColumn ( i ) );
+	std::sort ( pgwlp.begin(), pgwlp.end() );
+	for ( int i=0; i<ncols; i++ ) {
+		for ( size_t j=0; j<pgwlp[i].size(); j++ )
+			h = fingerprintcombine ( h, pgwlp[i][j] );
+	}
+
+	// the F4 vector is invariant for two-level designs
+	if ( al.is2level() && ncols>=4 ) {
+		std::vector<int> F4 = calculateF ( al, 4 );
+		for ( size_t i=0; i<F4.size(); i++ )
+			h = fingerprintcombine ( h, F4[i] );
+	}
+	return h;
+}
+
+std::vector<unsigned long long> isomorphismFingerprints ( const arraylist_t &arraylist, int verbose )
+{
+	const long narrays = arraylist.size();
+	std::vector<unsigned long long> result ( narrays );
+
+#ifdef DOOPENMP
+	#pragma omp parallel for schedule(dynamic,16)
+#endif
+	for ( long i=0; i<narrays; i++ ) {
+		result[i] = isomorphismFingerprint ( arraylist[i] );
+	}
+
+	if ( verbose )
+		myprintf ( "isomorphismFingerprints: calculated %ld fingerprints\n", narrays );
+	return result;
+}
+
+std::vector<int> fingerprintClasses ( const arraylist_t &arraylist, int verbose )
+{
+	const std::vector<unsigned long long> fingerprints = isomorphismFingerprints ( arraylist, verbose );
+
+	std::map<unsigned long long, int> classes;
+	std::vector<int> result ( fingerprints.size() );
+	for ( size_t i=0; i<fingerprints.size(); i++ ) {
+		std::map<unsigned long long, int>::const_iterator it = classes.find ( fingerprints[i] );
+		if ( it==classes.end() ) {
+			result[i] = i;
+			classes[fingerprints[i]] = i;
+		} else
+			result[i] = it->second;
+	}
+	if ( verbose )
+		myprintf ( "fingerprintClasses: %ld arrays, %ld classes\n", ( long ) fingerprints.size(), ( long ) classes.size() );
+	return result;
+}
+
 /// convert array to Eigen matrix structure
 Eigen::MatrixXd arraylink2eigen ( const array_link &al )
 {
@@ -1002,6 +1435,72 @@ void DAEefficiecyWithSVD ( const Eigen::MatrixXd &x, double &Deff, double &vif,
 }
 
 
+/** @brief Calculate the eigenvalues of the information matrix X^T X and the rank of X
+ *
+ * The eigenvalues are calculated from the m x m information matrix. Only if the condition number estimated from these
+ * eigenvalues is large, the singular values of X are calculated with a divide and conquer SVD to keep the accuracy for
+ * near-singular designs.
+ *
+ * @return Eigenvalues in increasing order
+ */
+static Eigen::VectorXd informationEigenvalues ( const Eigen::MatrixXd &x, int &rank, int verbose )
+{
+	const int m = x.cols();
+	const double maxcondition = 1e8;	// maximum condition number of X^T X for the eigenvalue backend
+
+	SelfAdjointEigenSolver<Eigen::MatrixXd> es ( x.transpose() *x, EigenvaluesOnly );
+	Eigen::VectorXd evs = es.eigenvalues();
+	if ( m==0 ) {
+		rank=0;
+		return evs;
+	}
+	if ( evs[0]*maxcondition > evs[m-1] ) {
+		rank=m;
+		return evs;
+	}
+
+	if ( verbose>=3 )
+		myprintf ( "informationEigenvalues: eigenvalues %e, %e: using SVD\n", evs[0], evs[m-1] );
+	BDCSVD<Eigen::MatrixXd> svd ( x );
+	const Eigen::VectorXd S = svd.singularValues();
+	rank = svd.rank();
+	evs.setZero();
+	for ( int i=0; i<S.size(); i++ )
+		evs[m-1-i] = S[i]*S[i];
+	return evs;
+}
+
+void DAEefficiency ( const Eigen::MatrixXd &x, double &Deff, double &vif, double &Eeff, int &rank, int verbose )
+{
+	const int m = x.cols();
+	const int N = x.rows();
+
+	const Eigen::VectorXd evs = informationEigenvalues ( x, rank, verbose );
+
+	Deff=0;
+	vif=0;
+	Eeff=0;
+	if ( m>N || m==0 )
+		return;
+	if ( evs[0]<1e-30 || rank < m ) {
+		if ( verbose>=2 )
+			myprintf ( "   array is singular, setting D-efficiency to zero\n" );
+		return;
+	}
+
+	Eeff = evs[0]/N;
+	double logdet=0;
+	for ( int i=0; i<m; i++ ) {
+		vif += 1/evs[i];
+		logdet += log ( evs[i] );
+	}
+	vif = N*vif/m;
+	Deff = exp ( logdet/m ) /N;
+
+	if ( verbose>=2 )
+		myprintf ( "DAEefficiency: Defficiency %.3f, Aefficiency %.3f (%.3f), Eefficiency %.3f\n", Deff, vif, vif*m, Eeff );
+}
+
 /** Calculate the rank of an orthogonal array (rank of [I X X_2] )
  *
  * The vector ret is filled with the rank, Defficiency, VIF efficiency and Eefficiency
@@ -1022,7 +1521,7 @@ int array_rank_D_B ( const array_link &al, std::vector<double> *ret  , int verbo
 	int rank;
 
 	//ABold(mymatrix, A, B, rank, verbose);
-	DAEefficiecyWithSVD ( mymatrix, Deff, B, Eeff, rank, verbose );
+	DAEefficiency ( mymatrix, Deff, B, Eeff, rank, verbose );
 
 	if ( ret!=0 ) {
 		ret->push_back ( rank );
@@ -1061,12 +1560,78 @@ double Eefficiency ( const array_link &al, int verbose )
 	return ret[3];
 }
 
+/// calculate the efficiencies from the eigenvalues of the information matrix X^T X (in increasing order)
+static efficiency_bundle_t efficiencyBundleFromEigenvalues ( const Eigen::VectorXd &evs, int rank, int N, int verbose )
+{
+	const int m = evs.size();
+	efficiency_bundle_t bundle;
+	bundle.Deff=0;
+	bundle.Aeff=0;
+	bundle.Eeff=0;
+	bundle.VIF=0;
+	bundle.rank=rank;
+	if ( m==0 || m>N )
+		return bundle;
+
+	if ( bundle.rank<m ) {
+		if ( verbose>=2 )
+			myprintf ( "efficiencyBundle: array is singular (rank %d/%d), setting efficiencies to zero\n", bundle.rank, m );
+		return bundle;
+	}
+
+	double logdet=0, vif=0;
+	for ( int i=0; i<m; i++ ) {
+		logdet += log ( evs[i] );
+		vif += 1/evs[i];
+	}
+	bundle.Deff = exp ( logdet/m ) /N;
+	bundle.VIF = N*vif/m;
+	bundle.Aeff = 1/bundle.VIF;
+	bundle.Eeff = evs[0]/N;
+	return bundle;
+}
+
+efficiency_bundle_t efficiencyBundle ( const array_link &al, int verbose )
+{
+	Eigen::MatrixXd mymatrix;
+	array2eigenxf ( al, mymatrix );
+
+	// a single symmetric eigenvalue decomposition of the information matrix
+	int rank;
+	const Eigen::VectorXd evs = informationEigenvalues ( mymatrix, rank, verbose );
+	efficiency_bundle_t bundle = efficiencyBundleFromEigenvalues ( evs, rank, al.n_rows, verbose );
+
+	if ( verbose>=2 )
+		myprintf ( "efficiencyBundle: rank %d, D %.4f, A %.4f, E %.4f, VIF %.4f\n", bundle.rank, bundle.Deff, bundle.Aeff, bundle.Eeff, bundle.VIF );
+	return bundle;
+}
+
+std::vector<efficiency_bundle_t> efficiencyBundle ( const arraylist_t &arraylist, int verbose )
+{
+	const long narrays = arraylist.size();
+	std::vector<efficiency_bundle_t> result ( narrays );
+
+#ifdef DOOPENMP
+	#pragma omp parallel for schedule(dynamic,16)
+#endif
+	for ( long i=0; i<narrays; i++ ) {
+		result[i] = efficiencyBundle ( arraylist[i], verbose>=2 );
+	}
+	return result;
+}
+
 std::vector<int> Jcharacteristics ( const array_link &al, int jj, int verbose )
 {
 	jstruct_t js ( al, jj );
 	return js.vals;
 }
 
+std::vector<int> Jcharacteristics ( const packedarray_t &pa, int jj )
+{
+	jstruct_t js ( pa, jj );
+	return js.vals;
+}
+
 /// calculate determinant of X^T X by using the SVD
 double detXtX ( const Eigen::MatrixXd &mymatrix, int verbose )
 {
@@ -1419,11 +1984,9 @@ double Defficiency ( const array_link &al, int verbose )
 	return Deff;
 }
 
-double CL2discrepancy ( const array_link &al )
+double CL2discrepancy ( const std::vector<double> &gwp )
 {
-	const int m = al.n_columns;
-
-	std::vector<double> gwp = al.GWLP();
+	const int m = gwp.size()-1;
 
 	double v = 1;
 	for ( int k=1; k<=m; k++ ) {
@@ -1434,6 +1997,81 @@ double CL2discrepancy ( const array_link &al )
 	return w;
 }
 
+double CL2discrepancy ( const array_link &al )
+{
+	return CL2discrepancy ( al.GWLP() );
+}
+
+arrayproperty_cache_t::entry_t &arrayproperty_cache_t::lookup ( const array_link &al )
+{
+	const unsigned long long h = al.hashvalue();
+
+	typedef std::multimap<unsigned long long, entry_t>::iterator iterator_t;
+	std::pair<iterator_t, iterator_t> range = entries.equal_range ( h );
+	for ( iterator_t it=range.first; it!=range.second; ++it ) {
+		if ( it->second.al==al )
+			return it->second;
+	}
+
+	if ( ( long ) entries.size() >=maxsize )
+		entries.clear();
+	iterator_t it = entries.insert ( std::pair<unsigned long long, entry_t> ( h, entry_t() ) );
+	it->second.al = al;
+	return it->second;
+}
+
+std::vector<double> arrayproperty_cache_t::GWLP ( const array_link &al )
+{
+	entry_t &e = lookup ( al );
+	if ( e.gwlp.size() ==0 ) {
+		nmisses++;
+		e.gwlp = al.GWLP();
+	} else
+		nhits++;
+	return e.gwlp;
+}
+
+std::vector<double> arrayproperty_cache_t::Defficiencies ( const array_link &al )
+{
+	entry_t &e = lookup ( al );
+	if ( e.deff.size() ==0 ) {
+		nmisses++;
+		e.deff = al.Defficiencies();
+	} else
+		nhits++;
+	return e.deff;
+}
+
+int arrayproperty_cache_t::rank ( const array_link &al )
+{
+	entry_t &e = lookup ( al );
+	if ( e.rank<0 ) {
+		nmisses++;
+		e.rank = al.rank();
+	} else
+		nhits++;
+	return e.rank;
+}
+
+std::vector<int> arrayproperty_cache_t::Jcharacteristics ( const array_link &al, int jj )
+{
+	entry_t &e = lookup ( al );
+	std::map<int, std::vector<int> >::iterator it = e.jvalues.find ( jj );
+	if ( it!=e.jvalues.end() ) {
+		nhits++;
+		return it->second;
+	}
+	nmisses++;
+	std::vector<int> j = al.Jcharacteristics ( jj );
+	e.jvalues[jj]=j;
+	return j;
+}
+
+double arrayproperty_cache_t::CL2discrepancy ( const array_link &al )
+{
+	return ::CL2discrepancy ( this->GWLP ( al ) );
+}
+
 #ifdef FULLPACKAGE
 
 Pareto<mvalue_t<long>,long> parsePareto ( const arraylist_t &arraylist, int verbose )
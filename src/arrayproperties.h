@@ -9,6 +9,8 @@
 #define ARRAYPROPERTIES_H
 
 
+#include <map>
+
 #include <Eigen/Core>
 #include <Eigen/SVD>
 //#include <Eigen/Dense>
@@ -27,6 +29,13 @@ double detXtXfloat(const Eigen::MatrixXf &mymatrix, int verbose=1);
 /// Calculate D-efficiency and VIF-efficiency and E-efficiency values using SVD
 void DAEefficiecyWithSVD(const Eigen::MatrixXd &x, double &Deff, double &vif, double &Eeff, int &rank, int verbose);
 
+/** @brief Calculate D-efficiency and VIF-efficiency and E-efficiency values
+ *
+ * The values are calculated from the eigenvalues of X^T X. For badly conditioned matrices the singular values of X are
+ * calculated with a divide and conquer SVD instead.
+ */
+void DAEefficiency(const Eigen::MatrixXd &x, double &Deff, double &vif, double &Eeff, int &rank, int verbose);
+
 /// Calculate the rank of the second order interaction matrix of an orthogonal array, the rank, D-efficiency, VIF-efficiency and E-efficiency are appended to the second argument
 int array_rank_D_B(const array_link &al, std::vector<double> *ret = 0, int verbose=0);
 
@@ -44,13 +53,62 @@ double Aefficiency(const array_link &al, int verbose=0);
 /// Calculate E-efficiency of matrix (1 over the VIF-efficiency)
 double Eefficiency(const array_link &al, int verbose=0);
 
+/// Efficiencies of the second order interaction model of a 2-level design
+struct efficiency_bundle_t {
+	/// rank of the model matrix
+	int rank;
+	/// D-efficiency
+	double Deff;
+	/// A-efficiency
+	double Aeff;
+	/// E-efficiency
+	double Eeff;
+	/// VIF-efficiency
+	double VIF;
+};
+
+/** @brief Calculate the rank, D-, A-, E- and VIF-efficiency of a 2-level design
+ *
+ * All values are calculated from a single symmetric eigenvalue decomposition of X^T X, with X the second order
+ * interaction matrix, with the same SVD fallback for badly conditioned designs as DAEefficiency. For singular designs
+ * the efficiencies are zero.
+ */
+efficiency_bundle_t efficiencyBundle(const array_link &al, int verbose=0);
+
+/// Calculate the rank, D-, A-, E- and VIF-efficiency for a list of 2-level designs
+std::vector<efficiency_bundle_t> efficiencyBundle(const arraylist_t &arraylist, int verbose=0);
+
 
 #ifdef FULLPACKAGE
-/// Return the D-efficiencies for the projection designs
-std::vector<double> projDeff(const array_link &al, int kp, int verbose);
+/** @brief Return the D-efficiencies for the projection designs
+ *
+ * If rankonly is true, only the rank of the information matrices is determined and the result contains 1 for the
+ * estimable projections and 0 otherwise.
+ */
+std::vector<double> projDeff(const array_link &al, int kp, int verbose=0, int rankonly=0);
 
 /// Return the projection estimation capacity sequence of a design
 std::vector<double> PECsequence(const array_link &al, int verbose=0);
+
+/// Estimate of the projection estimation capacity sequence
+struct pec_estimate_t {
+	/// estimated fraction of estimable projections for each number of factors
+	std::vector<double> pec;
+	/// lower bound of the 95% confidence interval
+	std::vector<double> lower;
+	/// upper bound of the 95% confidence interval
+	std::vector<double> upper;
+	/// number of projections evaluated
+	std::vector<long> nsamples;
+};
+
+/** @brief Estimate the projection estimation capacity sequence of a two-level design by sampling projections
+ *
+ * For each number of factors at most nsamples random projections are evaluated, within a total time budget of
+ * maxtime seconds. If the number of projections is at most nsamples the exact value is calculated. If nsamples is not
+ * positive an empty result is returned.
+ */
+pec_estimate_t PECsequenceMC(const array_link &al, long nsamples=20000, double maxtime=60, int verbose=0);
 #endif
 
 
@@ -70,6 +128,20 @@ std::vector<double> GWLP(const array_link &al, int verbose=0, int truncate=1);
 
 std::vector<double> GWLPmixed(const array_link &al, int verbose=0, int truncate=1);
 
+/// Calculate J-characteristics of a two-level design with packed columns
+std::vector<int> Jcharacteristics(const packedarray_t &pa, int jj=4);
+
+/// calculate GWLP of a two-level design with packed columns, the distance distribution is calculated with popcounts of the packed rows
+std::vector<double> GWLP(const packedarray_t &pa, int truncate=1);
+
+/** @brief Calculate the information matrix X^T X of the second order model of a two-level design with packed columns
+ *
+ * The model matrix X has the same ordering and coding as array2eigenModelMatrixInt. Each column of X is a bit vector
+ * (main effects are columns of the design, interactions the xor of two columns) and an element of X^T X is
+ * N-2 popcount(x_u xor x_v), so X itself is never formed.
+ */
+Eigen::MatrixXd secondOrderInformationMatrix(const packedarray_t &pa);
+
 
 // SWIG has some issues with typedefs, so we use a define
 //typedef double GWLPvalue;
@@ -87,18 +159,90 @@ std::vector< GWLPvalue > sortGWLP ( std::vector< GWLPvalue > );
 /// calculate delete-one-factor GWLP (generalized wordlength pattern) projection values
 std::vector<double> projectionGWLPvalues ( const array_link &al );
 
+/** @brief Calculate a fingerprint of a design that is invariant under row, column and level permutations
+ *
+ * The fingerprint is a 64-bit hash of the GWLP, the sorted delete-one-factor projection GWLPs and, for two-level
+ * designs, the F4 vector. Designs with different fingerprints are not isomorphic. Designs with equal fingerprints
+ * are very likely, but not necessarily, isomorphic.
+ */
+unsigned long long isomorphismFingerprint ( const array_link &al );
+
+/// Calculate the isomorphism fingerprints for a list of designs
+std::vector<unsigned long long> isomorphismFingerprints ( const arraylist_t &arraylist, int verbose=0 );
+
+/// For each design return the index of the first design in the list with the same isomorphism fingerprint
+std::vector<int> fingerprintClasses ( const arraylist_t &arraylist, int verbose=0 );
+
 /** calculate centered L2-discrepancy 
  * 
  * The method is from "A connection between uniformity and aberration in regular fractions of two-level factorials", Fang and Mukerjee, 2000
  */
 double CL2discrepancy(const array_link &al);
 
+/// calculate centered L2-discrepancy from the GWLP of a design
+double CL2discrepancy(const std::vector<double> &gwlp);
+
 /// add second order interactions to an array
 array_link array2xf(const array_link &al);
 
 /// calculate the rank of an array
 int arrayrank(const array_link &al);
 
+/** @brief Cache for properties of designs
+ *
+ * The properties are stored by a 64-bit hash of the array data. Since the key depends on the contents of the array,
+ * changing an array with setvalue or _setvalue invalidates the cached properties. On a hash match the stored copy of
+ * the array is compared with the array, so hash collisions cannot return wrong values.
+ *
+ * The cache is not thread-safe.
+ */
+class arrayproperty_cache_t
+{
+public:
+	/// maximum number of designs in the cache, if the cache is full it is cleared
+	long maxsize;
+	/// number of properties found in the cache
+	long nhits;
+	/// number of properties calculated
+	long nmisses;
+
+	arrayproperty_cache_t ( long maxsize = 100000 ) : maxsize ( maxsize ), nhits ( 0 ), nmisses ( 0 ) {}
+
+	/// return the GWLP of a design
+	std::vector<double> GWLP ( const array_link &al );
+	/// return the D-efficiency, Ds-efficiency and D1-efficiency of a design
+	std::vector<double> Defficiencies ( const array_link &al );
+	/// return the rank of a design
+	int rank ( const array_link &al );
+	/// return the J-characteristics of a design
+	std::vector<int> Jcharacteristics ( const array_link &al, int jj=4 );
+	/// return the centered L2-discrepancy of a design, the GWLP is shared with the GWLP method
+	double CL2discrepancy ( const array_link &al );
+
+	/// remove all designs from the cache
+	void clear() {
+		entries.clear();
+	}
+	/// number of designs in the cache
+	long size() const {
+		return entries.size();
+	}
+
+private:
+	struct entry_t {
+		array_link al;
+		std::vector<double> gwlp;
+		std::vector<double> deff;
+		int rank;
+		std::map<int, std::vector<int> > jvalues;
+
+		entry_t() : rank ( -1 ) {}
+	};
+	std::multimap<unsigned long long, entry_t> entries;
+
+	entry_t &lookup ( const array_link &al );
+};
+
 
 #ifdef FULLPACKAGE
 
@@ -107,6 +251,38 @@ int arrayrank(const array_link &al);
 // Calculate the Pareto optimal desings from a list of arrays
 Pareto<mvalue_t<long>,long> parsePareto(const arraylist_t &arraylist, int verbose);
 
+/// filter for filterArrayFile: keep the arrays with a D-efficiency of at least the threshold. The properties are the D-, Ds- and D1-efficiency
+class Defficiency_filter_t : public arraystream_filter_t
+{
+public:
+	double threshold;
+
+	Defficiency_filter_t ( double threshold_ ) : threshold ( threshold_ ) {}
+
+	std::vector<double> properties ( const array_link &al ) const {
+		return al.Defficiencies();
+	}
+	bool keep ( const array_link &al, const std::vector<double> &properties ) const {
+		return properties[0]>=threshold;
+	}
+};
+
+/// filter for filterArrayFile: keep the arrays with an A3 value of at most the threshold. The properties are the GWLP
+class GWLP_filter_t : public arraystream_filter_t
+{
+public:
+	double maxA3;
+
+	GWLP_filter_t ( double maxA3_ ) : maxA3 ( maxA3_ ) {}
+
+	std::vector<double> properties ( const array_link &al ) const {
+		return al.GWLP();
+	}
+	bool keep ( const array_link &al, const std::vector<double> &properties ) const {
+		return properties.size() <4 || properties[3]<=maxA3+1e-10;
+	}
+};
+
 template <class IndexType>
 /** Add array to list of Pareto optimal arrays
  * 
@@ -22,6 +22,10 @@
 #include <Eigen/Core>
 #include <Eigen/Dense>
 
+#ifdef DOOPENMP
+#include "omp.h"
+#endif
+
 using namespace std;
 
 #ifdef WIN32
@@ -735,6 +739,42 @@ std::string array_link::md5() const
 #endif
 }
 
+unsigned long long array_link::hashvalue() const
+{
+	// the data is read as 64-bit words, which are hashed in four independent lanes so the compiler can vectorize the loop
+	const unsigned long long prime = 0x9e3779b97f4a7c15ULL;
+	const size_t nbytes = ( size_t ) this->n_rows*this->n_columns*sizeof ( array_t );
+	const size_t nwords = nbytes/8;
+	const unsigned char *data = ( const unsigned char * ) this->array;
+
+	unsigned long long lanes[4] = {1ULL, 2ULL, 3ULL, 4ULL};
+	size_t w=0;
+	for ( ; w+4<=nwords; w+=4 ) {
+		unsigned long long x[4];
+		memcpy ( x, data+8*w, 32 );
+		for ( int l=0; l<4; l++ ) {
+			lanes[l] = ( lanes[l] ^ x[l] ) * prime;
+			lanes[l] ^= lanes[l] >> 29;
+		}
+	}
+	for ( ; w<nwords; w++ ) {
+		unsigned long long x;
+		memcpy ( &x, data+8*w, 8 );
+		lanes[w%4] = ( lanes[w%4] ^ x ) * prime;
+		lanes[w%4] ^= lanes[w%4] >> 29;
+	}
+	if ( nbytes>8*nwords ) {
+		unsigned long long x=0;
+		memcpy ( &x, data+8*nwords, nbytes-8*nwords );
+		lanes[0] = ( lanes[0] ^ x ) * prime;
+	}
+
+	unsigned long long h = fmix64 ( ( ( unsigned long long ) this->n_rows << 32 ) ^ ( unsigned long long ) this->n_columns );
+	for ( int l=0; l<4; l++ )
+		h = fmix64 ( h ^ lanes[l] ) + l;
+	return h;
+}
+
 #ifdef FULLPACKAGE
 
 /**
@@ -1942,9 +1982,7 @@ double array_link::Eefficiency() const
 
 std::vector<int> array_link::Fvalues ( int jj ) const
 {
-	jstruct_t js ( *this, jj );
-	std::vector<int> FF=js.calculateF();
-	return FF;
+	return ::calculateF ( *this, jj );
 }
 
 #ifdef FULLPACKAGE
@@ -1966,16 +2004,7 @@ int array_link::rank() const
 
 int array_link::strength() const
 {
-	int t=-1;
-	for ( int i=0; i<=this->n_columns; i++ ) {
-		int b = strength_check ( *this, i );
-		// myprintf("strength_check %d->%d\n", i, b);
-		if ( b )
-			t=i;
-		else
-			break;
-	}
-	return t;
+	return arraystrength ( *this );
 }
 
 int array_cmp ( carray_p A, carray_p B, const rowindex_t r, const colindex_t c )
@@ -2091,6 +2120,63 @@ arraydata_t::arraydata_t ( const arraydata_t &adp ) : N ( adp.N ), ncols ( adp.n
 	memcpy ( s, adp.s, sizeof ( array_t ) *ncols );
 	complete_arraydata();
 }
+
+#if __cplusplus >= 201103L
+arraydata_t::arraydata_t ( arraydata_t &&adp ) noexcept : N ( adp.N ), ncols ( adp.ncols ), strength ( adp.strength ), s ( adp.s ), order ( adp.order ), ncolgroups ( adp.ncolgroups ), colgroupindex ( adp.colgroupindex ), colgroupsize ( adp.colgroupsize ), oaindex ( adp.oaindex )
+{
+	adp.s=0;
+	adp.ncols=0;
+	adp.ncolgroups=0;
+	adp.colgroupindex=0;
+	adp.colgroupsize=0;
+}
+
+arraydata_t& arraydata_t::operator= ( arraydata_t &&ad2 ) noexcept
+{
+	if ( this==&ad2 )
+		return *this;
+	std::swap ( this->N, ad2.N );
+	std::swap ( this->ncols, ad2.ncols );
+	std::swap ( this->strength, ad2.strength );
+	std::swap ( this->s, ad2.s );
+	std::swap ( this->order, ad2.order );
+	std::swap ( this->ncolgroups, ad2.ncolgroups );
+	std::swap ( this->colgroupindex, ad2.colgroupindex );
+	std::swap ( this->colgroupsize, ad2.colgroupsize );
+	std::swap ( this->oaindex, ad2.oaindex );
+	return *this;
+}
+#endif
+
+arraydata_t& arraydata_t::operator= ( const arraydata_t &ad2 )
+{
+	if ( this==&ad2 )
+		return *this;
+	this->N = ad2.N;
+	this->strength=ad2.strength;
+	this->ncols=ad2.ncols;
+	this->order=ad2.order;
+	this->oaindex=ad2.oaindex;
+	delete [] s;
+	this->s = new array_t[this->ncols];
+	std::copy ( ad2.s, ad2.s+this->ncols, s );
+
+	// the column groups can differ from the default groups, so they are copied instead of recalculated
+	delete [] colgroupindex;
+	delete [] colgroupsize;
+	this->ncolgroups = ad2.ncolgroups;
+	this->colgroupindex=0;
+	this->colgroupsize=0;
+	if ( ad2.colgroupindex!=0 ) {
+		this->colgroupindex = new colindex_t[ncolgroups+1];
+		std::copy ( ad2.colgroupindex, ad2.colgroupindex+ncolgroups+1, this->colgroupindex );
+	}
+	if ( ad2.colgroupsize!=0 ) {
+		this->colgroupsize = new colindex_t[ncolgroups+1];
+		std::copy ( ad2.colgroupsize, ad2.colgroupsize+ncolgroups+1, this->colgroupsize );
+	}
+	return *this;
+}
 arraydata_t::~arraydata_t()
 {
 	//myprintf("~arraydata_t\n");
@@ -2464,6 +2550,9 @@ void arraydata_t::complete_arraydata_fixlast()
 jstruct_t::jstruct_t()
 {
 // myprintf("jstruct_t()\n");
+	this->N=0;
+	this->k=0;
+	this->jj=4;
 	this->nc=0;
 	this->A=-1;
 }
@@ -2512,81 +2601,212 @@ void jstruct_t::calc ( const array_link &al )
 	delete_perm ( pp );
 }
 
-void jstruct_t::calcj4 ( const array_link &al )
-{
-	// myprintf ( "jstruct_t::calcj4\n" );
-	assert ( jj==4 );
-	int *pp = new_perm_init<int> ( jj );
-	int ncolcombs = ncombs ( k, jj );
-	const int nr = al.n_rows;
-	const int N = nr;
-
-	// fill double column table
-	array_link dtable ( nr, al.n_columns*al.n_columns, -1 );
-
-	// loop over all column pairs
-	for ( int i=0; i<al.n_columns; i++ ) {
-		for ( int j=0; j<al.n_columns; j++ ) {
-			int idx=i+j*al.n_columns;
-			// loop over all rows of original array
-			for ( int x=0; x<nr; x++ ) {
-				//dtable.array[x+idx*dtable.n_rows] = al.atfast ( x, i ) + al.atfast ( x, j );
-				dtable.array[x+idx*dtable.n_rows] = al.array[x+al.n_rows*i] + al.array[x+al.n_rows*j];
+/** @brief Packed parity bits of the column pairs of an array
+ *
+ * The J4-characteristic of the columns a<b<c<d only depends on the parity of x_a+x_b+x_c+x_d in each row.
+ * For each pair a<b we store the parity of x_a+x_b as a bit vector, so a J4-value is the popcount of the xor
+ * of two pair vectors. Only the upper triangle is stored. The pairs are ordered in colex order (index a+b(b-1)/2),
+ * so the pairs (a,b) with b<c form a contiguous block at the start of the table.
+ */
+class j4pairtable_t
+{
+public:
+	int N;
+	int k;
+	/// number of 64-bit words per column pair
+	int nw;
+	std::vector<unsigned long long> bits;
+
+	j4pairtable_t ( const array_link &al ) : N ( al.n_rows ), k ( al.n_columns ), nw ( ( al.n_rows+63 ) /64 ) {
+		std::vector<unsigned long long> colbits ( ( size_t ) k*nw, 0 );
+		for ( int c=0; c<k; c++ ) {
+			const array_t *col = al.array+c*N;
+			unsigned long long *w = &colbits[ ( size_t ) c*nw];
+			for ( int r=0; r<N; r++ ) {
+				w[r/64] |= ( ( unsigned long long ) ( col[r] & 1 ) ) << ( r%64 );
 			}
-
 		}
+		this->init ( colbits.empty() ? 0 : &colbits[0] );
 	}
 
-	//myprintf("dtable\n"); dtable.showarray();
+	j4pairtable_t ( const packedarray_t &pa ) : N ( pa.n_rows ), k ( pa.n_columns ), nw ( pa.nw ) {
+		this->init ( pa.words.empty() ? 0 : &pa.words[0] );
+	}
 
-	for ( int x=0; x<this->nc; x++ ) {
-		//int jv = jvalue ( al, jj, pp );  this->vals[x]=jv;
-		const int idx1= pp[0]+pp[1]*al.n_columns;
-		const int idx2= pp[2]+pp[3]*al.n_columns;
-		int jv=0;
-		if ( 0 ) {
-			for ( int xr=0; xr<nr; xr++ ) {
-				int tmp = dtable.atfast ( xr, idx1 ) +dtable.atfast ( xr, idx2 );
-				tmp %= 2;
-				jv += tmp;
-				// tmp *=2; tmp--;jv -= tmp;
+	/// return pointer to the parity bits of the column pair (a, b) with a<b
+	inline const unsigned long long *pair ( int a, int b ) const {
+		return &bits[ ( size_t ) ( a+b* ( b-1 ) /2 ) *nw];
+	}
+
+private:
+	void init ( const unsigned long long *colbits ) {
+		bits.resize ( ( size_t ) ( k* ( k-1 ) /2 ) *nw );
+		unsigned long long *p = bits.empty() ? 0 : &bits[0];
+		for ( int b=1; b<k; b++ ) {
+			const unsigned long long *wb = colbits+ ( size_t ) b*nw;
+			for ( int a=0; a<b; a++ ) {
+				const unsigned long long *wa = colbits+ ( size_t ) a*nw;
+				for ( int w=0; w<nw; w++ )
+					p[w] = wa[w] ^ wb[w];
+				p += nw;
 			}
-		} {
-			const array_t *o1 = dtable.array+dtable.n_rows*idx1;
-			const array_t *o2 = dtable.array+dtable.n_rows*idx2;
-			for ( int xr=0; xr<nr; xr++ ) {
-				int tmp = o1[xr]  + o2[xr]; // dtable.atfast ( xr, idx2 );
-				tmp %= 2;
-				jv += tmp;
+		}
+	}
+};
+
+template <class Visitor>
+/** Loop over all J4-characteristics of an array
+ *
+ * The J-values are passed to the visitor in the ordering generated by next_comb_s. For a fixed pair (c,d) the
+ * matching pairs (a,b) are a contiguous prefix of the pair table, so the inner loop streams through memory.
+ */
+void j4loop ( const j4pairtable_t &table, Visitor &visitor )
+{
+	const int k = table.k;
+	const int N = table.N;
+	const int nw = table.nw;
+
+	for ( int d=3; d<k; d++ ) {
+		for ( int c=2; c<d; c++ ) {
+			const unsigned long long *pcd = table.pair ( c, d );
+			const unsigned long long *pab = table.pair ( 0, 1 );
+			const int npairs = c* ( c-1 ) /2;
+			for ( int p=0; p<npairs; p++ ) {
+				int nodd=0;
+				for ( int w=0; w<nw; w++ )
+					nodd += popcount64 ( pab[w] ^ pcd[w] );
+				visitor ( 2*nodd-N );
+				pab += nw;
 			}
-//			jv %= 2;
 		}
-		jv = 2*jv-N;
-		this->vals[x]=jv;
-		//myprintf(" val %d -> %d\n", jvalue ( al, jj, pp ), jv); myprintf("  perm "); print_perm(pp, jj);
+	}
+}
 
-		next_comb_s ( pp, jj, k );
+template <class Visitor>
+/// Loop over all J4-characteristics of an array, see j4loop
+void j4loop ( const array_link &al, Visitor &visitor )
+{
+	if ( al.n_columns<4 )
+		return;
+	const j4pairtable_t table ( al );
+	j4loop ( table, visitor );
+}
+
+/// helper class: store J-values in a vector
+struct j4store_t {
+	int *vals;
+	j4store_t ( int *v ) : vals ( v ) {}
+	inline void operator() ( int jv ) {
+		*vals++ = jv;
 	}
+};
 
-	delete_perm ( pp );
+/// helper class: histogram and sum of squares of J-values
+struct j4histogram_t {
+	int N;
+	int x;
+	std::vector<int> F;
+	long sumsq;
+	j4histogram_t ( int N_, int strength ) : N ( N_ ), sumsq ( 0 ) {
+		x = 1 << ( strength+1 );
+		F.resize ( N/x+1 );
+	}
+	inline void operator() ( int jv ) {
+		F[ ( N-abs ( jv ) ) /x]++;
+		sumsq += jv*jv;
+	}
+};
+
+void jstruct_t::calcj4 ( const array_link &al )
+{
+	assert ( jj==4 );
+	if ( this->nc==0 )
+		return;
+	j4store_t store ( &this->vals[0] );
+	j4loop ( al, store );
 }
 
+std::vector<int> calculateF ( const array_link &al, int jj, int strength )
+{
+	if ( jj!=4 ) {
+		jstruct_t js ( al, jj );
+		return js.calculateF ( strength );
+	}
+	j4histogram_t histogram ( al.n_rows, strength );
+	j4loop ( al, histogram );
+	return histogram.F;
+}
 
 jstruct_t::jstruct_t ( const array_link &al, int jj )
 {
-	const int k=al.n_columns;
-	const int N = al.n_rows;
+	this->init ( al.n_rows, al.n_columns, jj );
+	this->calculate ( al );
+}
+
+jstruct_t::jstruct_t ( const packedarray_t &pa, int jj )
+{
+	this->init ( pa.n_rows, pa.n_columns, jj );
+	this->calculate ( pa );
+}
+
+void jstruct_t::calculate ( const packedarray_t &pa )
+{
+	if ( pa.n_rows!=this->N || pa.n_columns!=this->k || this->nc!=ncombsm<long> ( pa.n_columns, this->jj ) )
+		this->init ( pa.n_rows, pa.n_columns, this->jj );
+
+	this->calc ( pa );
+	this->calculateAberration();
+}
+
+/** Calculate the J-characteristics from the packed columns of a two-level array
+ *
+ * The J-value of a set of columns is determined by the number of rows with odd parity, which is the popcount of the
+ * xor of the columns. The values are the same as calculated by calc and calcj4.
+ */
+void jstruct_t::calc ( const packedarray_t &pa )
+{
+	if ( this->nc==0 )
+		return;
+	if ( jj==4 ) {
+		if ( k<4 )
+			return;
+		const j4pairtable_t table ( pa );
+		j4store_t store ( &this->vals[0] );
+		j4loop ( table, store );
+		return;
+	}
+
+	const int nw = pa.nw;
+	std::vector<unsigned long long> parity ( nw );
+	int *pp = new_perm_init<int> ( jj );
+	for ( int x=0; x<this->nc; x++ ) {
+		std::fill ( parity.begin(), parity.end(), 0 );
+		for ( int i=0; i<jj; i++ ) {
+			const unsigned long long *col = pa.column ( pp[i] );
+			for ( int w=0; w<nw; w++ )
+				parity[w] ^= col[w];
+		}
+		int nodd=0;
+		for ( int w=0; w<nw; w++ )
+			nodd += popcount64 ( parity[w] );
+		this->vals[x] = N-2*nodd;
+		next_comb_s ( pp, jj, k );
+	}
+	delete_perm ( pp );
+}
 
+void jstruct_t::calculate ( const array_link &al )
+{
+	if ( al.n_rows!=this->N || al.n_columns!=this->k || this->nc!=ncombsm<long> ( al.n_columns, this->jj ) )
+		this->init ( al.n_rows, al.n_columns, this->jj );
 
-	this->init ( N, k, jj );
-	if ( jj==4 && 1 )
+	if ( jj==4 )
 		this->calcj4 ( al );
 	else
 		this->calc ( al );
 
 	// calculate A value
 	this->calculateAberration();
-
 }
 
 jstruct_t::jstruct_t ( const int N_, const int k_, const int jj_ )
@@ -2609,7 +2829,7 @@ void jstruct_t::init ( int N_, int k_, int jj_ )
 		jj=0;
 	}
 
-	this->nc = ncombs ( k_, jj_ );
+	this->nc = ncombsm<long> ( k_, jj_ );
 	vals = std::vector<int> ( nc );
 //  myprintf("jstruct_t(N,k,jj): vals %d\n", this->vals);
 	this->A=-1;
@@ -2712,51 +2932,96 @@ int jvalue ( const array_link &ar,const int J, const int *pp )
  */
 vector<jstruct_t> analyseArrays ( const arraylist_t &arraylist,  const int verbose, const int jj )
 {
-	//vector<jstruct_t> results(arraylist.size());
-
 	if ( verbose ) {
 		myprintf ( "analyseArrays (j-values): %ld arrays, jj %d\n", ( long ) arraylist.size(), jj );
 	}
 
 	vector<jstruct_t> results;
 	results.reserve ( arraylist.size() );
-	jstruct_t *js ;
 
-	//myprintf("analyseArrays: start\n");
 	for ( unsigned int ii=0; ii<arraylist.size(); ii++ ) {
+		const array_link &ll = arraylist.at ( ii );
 
-		const array_link ll = arraylist.at ( ii );
-		//const int k=ll.n_columns;
-
-		int *pp = new_perm_init<int> ( jj );
-		//int ncolcombs = ncombs ( k, jj );
-
-		js = new jstruct_t ( ll, jj );
+		results.push_back ( jstruct_t ( ll, jj ) );
 
 #ifdef FULLPACKAGE
+		const jstruct_t &js = results.back();
 		if ( verbose>=3 ) {
-			cout << printfstring ( "array %d: abberation %.3f j-values ", ii, js->A );
-			print_perm ( cout, js->vals, js->nc );
+			cout << printfstring ( "array %d: abberation %.3f j-values ", ii, js.A );
+			print_perm ( cout, js.vals, js.nc );
 		}
 		if ( verbose>=2 ) {
-			std::vector<int> FF=js->calculateF();
+			std::vector<int> FF=js.calculateF();
 			myprintf ( "F%d (high to low): ", jj );
 			display_vector ( FF );
 			std::cout << std::endl;
 		}
 #endif
-		delete_perm ( pp );
-		//delete [] js;
-
-		results.push_back ( *js );
-		///results[ii]=*js; printf("assign\n");
-		delete js;
 	}
 
-	// myprintf("analyseArrays: return value\n");
 	return results;
 }
 
+Eigen::MatrixXi analyseArraysF ( const arraylist_t &arraylist, int jj, std::vector<double> *aberration, std::vector<std::vector<int> > *jvalues, int verbose )
+{
+	const long narrays = arraylist.size();
+	const int strength = 3;
+
+	int Nmax=0;
+	for ( long i=0; i<narrays; i++ )
+		Nmax = std::max ( Nmax, ( int ) arraylist[i].n_rows );
+	const int nF = Nmax/ ( 1 << ( strength+1 ) ) +1;
+
+	if ( verbose )
+		myprintf ( "analyseArraysF: %ld arrays, jj %d\n", narrays, jj );
+
+	Eigen::MatrixXi FF = Eigen::MatrixXi::Zero ( narrays, nF );
+	if ( aberration!=0 )
+		aberration->resize ( narrays );
+	if ( jvalues!=0 )
+		jvalues->resize ( narrays );
+
+	// the J-values only need to be stored if requested, or if no streaming method is available
+	const bool storej = ( jvalues!=0 ) || ( jj!=4 );
+
+#ifdef DOOPENMP
+	#pragma omp parallel
+#endif
+	{
+		// buffer for the J-values, reused for all arrays handled by this thread
+		jstruct_t js;
+		js.jj = jj;
+
+#ifdef DOOPENMP
+		#pragma omp for schedule(dynamic,16)
+#endif
+		for ( long i=0; i<narrays; i++ ) {
+			const array_link &al = arraylist[i];
+
+			std::vector<int> F;
+			double A;
+			if ( storej ) {
+				js.calculate ( al );
+				F = js.calculateF ( strength );
+				A = js.A;
+				if ( jvalues!=0 )
+					jvalues->at ( i ) = js.vals;
+			} else {
+				j4histogram_t histogram ( al.n_rows, strength );
+				j4loop ( al, histogram );
+				F = histogram.F;
+				A = double ( histogram.sumsq ) / ( al.n_rows*al.n_rows );
+			}
+
+			for ( size_t j=0; j<F.size(); j++ )
+				FF ( i, j ) = F[j];
+			if ( aberration!=0 )
+				aberration->at ( i ) = A;
+		}
+	}
+
+	return FF;
+}
 
 
 
@@ -2898,8 +3163,38 @@ void readblob ( TypeOut *dst, int n, gzFile gzfid )
 #endif
 
 
+#if defined(WIN32) || defined(_WIN32)
+#define oa_getc getc
+#else
+#define oa_getc getc_unlocked
+#endif
+
+/// read an integer from a file, leading whitespace is skipped. returns 0 on success
+inline int read_int ( FILE *fid, int &value )
+{
+	int c = oa_getc ( fid );
+	while ( c==' ' || c=='\n' || c=='\r' || c=='\t' )
+		c = oa_getc ( fid );
+	int sign=1;
+	if ( c=='-' ) {
+		sign=-1;
+		c = oa_getc ( fid );
+	}
+	if ( c<'0' || c>'9' )
+		return 1;
+	int v=0;
+	while ( c>='0' && c<='9' ) {
+		v = 10*v + ( c-'0' );
+		c = oa_getc ( fid );
+	}
+	value = sign*v;
+	return 0;
+}
+
 /**
  * @brief Read an array from a file
+ *
+ * The values are read row by row, there is no limit on the length of a row.
  * @param fid
  * @param array
  * @param nrows
@@ -2907,25 +3202,24 @@ void readblob ( TypeOut *dst, int n, gzFile gzfid )
  */
 void read_array ( FILE *fid, array_t *array, const int nrows, const int ncols )
 {
-	const int maxbuf = 1024;
-	char buf[maxbuf];
-	int count;
+	int value=0;
 	for ( int j = 0; j < nrows; j++ ) {
-		count = j;
-
-		char *r = fgets ( buf, maxbuf, fid );
-		stringstream ss ( stringstream::in | stringstream::out );
-		ss << buf;
-
 		for ( int k = 0; k < ncols; k++ ) {
-			ss >> array[count];
-			count += nrows;
+			if ( read_int ( fid, value ) ) {
+				myprintf ( "read_array: error parsing value at row %d, column %d\n", j, k );
+				return;
+			}
+			array[j+k*nrows] = value;
 		}
-
 	}
+	// skip the end of the last line
+	int c = oa_getc ( fid );
+	while ( c==' ' || c=='\r' )
+		c = oa_getc ( fid );
+	if ( c!='\n' && c!=EOF )
+		ungetc ( c, fid );
 }
 
-
 #ifdef HAVE_BOOST
 #include "boost/filesystem.hpp"
 #endif
@@ -2950,89 +3244,593 @@ bool file_exists ( const char *filename )
 
 #ifdef FULLPACKAGE 	// related to arrayfile_t
 
-bool arrayfile_t::isbinary() const
+/// parse an integer from a text buffer, leading whitespace is skipped. returns the position after the number or 0 on error
+inline const char *parse_int ( const char *p, const char *end, int &value )
 {
-	return ( this->mode==ABINARY || this->mode==ABINARY_DIFF || this->mode==ABINARY_DIFFZERO );
+	while ( p<end && ( *p==' ' || *p=='\n' || *p=='\r' || *p=='\t' ) )
+		p++;
+	if ( p==end )
+		return 0;
+	int sign=1;
+	if ( *p=='-' ) {
+		sign=-1;
+		p++;
+	}
+	if ( p==end || *p<'0' || *p>'9' )
+		return 0;
+	int v=0;
+	while ( p<end && *p>='0' && *p<='9' ) {
+		v = 10*v + ( *p-'0' );
+		p++;
+	}
+	value = sign*v;
+	return p;
 }
 
+/** @brief Find the start of the arrays in the data section of a text array file
+ *
+ * Every array consists of a line with the index and one line per row. The list of arrays ends with index -1 or at the
+ * end of the file. An array is only accepted if all its lines are in the data, the last line can only be without
+ * newline at the end of the file.
+ *
+ * @param data Text data, starting after the header line
+ * @param n Size of the data
+ * @param nrows Number of rows of the arrays
+ * @param narrays Maximum number of arrays to find, -1 for no limit
+ * @param eof True if the data extends to the end of the file
+ * @param endpos Position after the last array found
+ * @param finished Set to true if the end of the list of arrays or the maximum number of arrays has been reached
+ * @return Offsets of the arrays in the data
+ */
+static std::vector<size_t> text_array_offsets ( const char *data, size_t n, int nrows, long narrays, bool eof, size_t &endpos, bool &finished )
+{
+	std::vector<size_t> offsets;
+	const char *end = data+n;
+	const char *p = data;
+	finished=false;
+	while ( p<end ) {
+		if ( narrays>=0 && ( long ) offsets.size() >=narrays ) {
+			finished=true;
+			break;
+		}
+		int index;
+		if ( parse_int ( p, end, index ) ==0 ) {
+			// whitespace or a minus sign at the end of the window can be followed by more data, anything else ends the list
+			const char *r = p;
+			while ( r<end && ( *r==' ' || *r=='\n' || *r=='\r' || *r=='\t' ) )
+				r++;
+			finished = eof || ( r<end && ! ( *r=='-' && r+1==end ) );
+			break;
+		}
+		if ( index==-1 ) {
+			finished=true;
+			break;
+		}
+		const char *q = p;
+		int nlines=0;
+		for ( ; nlines<nrows+1; nlines++ ) {
+			q = ( const char * ) memchr ( q, '\n', end-q );
+			if ( q==0 )
+				break;
+			q++;
+		}
+		if ( nlines<nrows+1 && ! ( eof && nlines==nrows ) )
+			break;	// incomplete array at the end of the data
+		offsets.push_back ( p-data );
+		if ( q==0 ) {
+			p=end;
+			break;
+		}
+		p=q;
+	}
+	if ( narrays>=0 && ( long ) offsets.size() >=narrays )
+		finished=true;
+	endpos = p-data;
+	return offsets;
+}
 
-void arrayfile_t::append_array ( const array_link &a, int specialindex )
+/// parse a single array from a text buffer, return the index of the array or -1 on error
+static int parse_text_array ( const char *p, const char *end, array_t *array, const int nrows, const int ncols )
 {
-	int r;
-	if ( ! this->isopen() ) {
-		return;
+	int index;
+	p = parse_int ( p, end, index );
+	if ( p==0 )
+		return -1;
+	for ( int j = 0; j < nrows; j++ ) {
+		for ( int k = 0; k < ncols; k++ ) {
+			int value;
+			p = parse_int ( p, end, value );
+			if ( p==0 )
+				return -1;
+			array[j+k*nrows] = value;
+		}
 	}
+	return index;
+}
 
-	arrayfile_t *afile = this;
-	int index;
-	if ( specialindex==-1 )
-		index=a.index;
-	else
-		index=specialindex;
+/** @brief Read all remaining arrays from a text array file
+ *
+ * The remainder of the file is read in windows of 4 MB. The complete arrays in a window are determined from the line
+ * structure and parsed in parallel, the incomplete array at the end of the window is carried over to the next window.
+ * The memory used besides the array list is therefore bounded by the window size (or the size of a single array).
+ *
+ * @return Number of arrays read, or -1 if the arrays could not be parsed
+ */
+static long read_text_arrays ( FILE *fid, int nrows, int ncols, long narrays, arraylist_t &rl, int verbose )
+{
+	const size_t start = rl.size();
+	const size_t chunk = 1<<22;
+	std::vector<char> buffer;
+	size_t nused=0;	// size of the data carried over from the previous window
+	long nread=0;
+	bool eof=false;
+	while ( !eof && ( narrays<0 || nread<narrays ) ) {
+		buffer.resize ( nused+chunk );
+		size_t r = fread ( &buffer[nused], 1, chunk, fid );
+		eof = r<chunk;
+		const size_t n = nused+r;
+		if ( n==0 )
+			break;
 
-	switch ( afile->mode ) {
-	case arrayfile::ATEXT:
-		fprintf ( afile->nfid, "%i\n", index );
-		write_array ( afile->nfid, a.array, a.n_rows, a.n_columns );
+		const char *data = &buffer[0];
+		size_t endpos;
+		bool finished;
+		std::vector<size_t> offsets = text_array_offsets ( data, n, nrows, ( narrays<0 ) ? -1 : narrays-nread, eof, endpos, finished );
+		const long na = offsets.size();
+		if ( verbose>=2 )
+			myprintf ( "read_text_arrays: found %ld arrays in window\n", na );
+
+		const size_t pos = rl.size();
+		rl.resize ( pos+na );
+		for ( long i=0; i<na; i++ )
+			rl[pos+i].init ( nrows, ncols );
+
+		long nerrors=0;
+#ifdef DOOPENMP
+		#pragma omp parallel for schedule(dynamic,64) reduction(+:nerrors) if(na>500)
+#endif
+		for ( long i=0; i<na; i++ ) {
+			array_link &al = rl[pos+i];
+			const char *e = ( i+1<na ) ? data+offsets[i+1] : data+endpos;
+			al.index = parse_text_array ( data+offsets[i], e, al.array, nrows, ncols );
+			if ( al.index<0 )
+				nerrors++;
+		}
+		if ( nerrors>0 ) {
+			myprintf ( "read_text_arrays: error parsing %ld arrays\n", nerrors );
+			rl.resize ( start );
+			return -1;
+		}
+		nread += na;
+
+		if ( finished )
+			break;
+
+		// move the incomplete array at the end of the window to the start of the buffer
+		const size_t keep = endpos;
+		nused = n-keep;
+		if ( nused>0 )
+			memmove ( &buffer[0], &buffer[keep], nused );
+	}
+	return nread;
+}
+
+
+/// encode an array in the record format of binary array files: the index followed by the packed values
+static void encode_array_record ( const array_t *array, const int n, const int nbits, int32_t index, unsigned char *dst )
+{
+	memcpy ( dst, &index, sizeof ( int32_t ) );
+	dst += sizeof ( int32_t );
+	switch ( nbits ) {
+	case 1: {
+		const int nw = nwords ( n );
+		const int wbits = 8*sizeof ( word_t );
+		for ( int w=0; w<nw; w++ ) {
+			word_t word=0;
+			const int jmax = std::min ( wbits, n-w*wbits );
+			const array_t *src = array+w*wbits;
+			for ( int j=0; j<jmax; j++ ) {
+				if ( src[j] )
+					word |= ( ( word_t ) 1 ) <<j;
+			}
+			memcpy ( dst+w*sizeof ( word_t ), &word, sizeof ( word_t ) );
+		}
 		break;
-	case arrayfile::ALATEX:
-		fprintf ( afile->nfid, "%i\n", index );
-		write_array_latex ( afile->nfid, a.array, a.n_rows, a.n_columns );
+	}
+	case 8:
+		for ( int j=0; j<n; j++ )
+			dst[j] = ( char ) array[j];
 		break;
-	case arrayfile::ABINARY: {
-		r = fwrite ( &index, 1, sizeof ( int32_t ), afile->nfid );
-		if ( r!=sizeof ( int32_t ) *1 ) {
-			printfd ( "error during write to file\n" );
+	case 32:
+		for ( int j=0; j<n; j++ ) {
+			int32_t v = array[j];
+			memcpy ( dst+4*j, &v, sizeof ( int32_t ) );
 		}
-		//printf("   %d %d\n", a.n_rows, a.n_columns);
-		afile->write_array_binary ( a.array, a.n_rows, a.n_columns );
+		break;
+	default
+			:
+		myprintf ( "encode_array_record: error: number of bits %d not supported\n", nbits );
 		break;
 	}
-	case arrayfile::ABINARY_DIFF: {
-		fwrite ( &index, 1, sizeof ( int32_t ), afile->nfid );
-		afile->write_array_binary_diff ( a );
+}
+
+/// decode the packed values of a binary array record (without the index), the data is not necessarily aligned
+static void decode_array_record ( const unsigned char *src, const int n, const int nbits, array_t *array )
+{
+	switch ( nbits ) {
+	case 1: {
+		const int nw = nwords ( n );
+		const int wbits = 8*sizeof ( word_t );
+		for ( int w=0; w<nw; w++ ) {
+			word_t word;
+			memcpy ( &word, src+w*sizeof ( word_t ), sizeof ( word_t ) );
+			const int jmax = std::min ( wbits, n-w*wbits );
+			array_t *dst = array+w*wbits;
+			for ( int j=0; j<jmax; j++ )
+				dst[j] = ( word>>j ) & 1;
+		}
 		break;
 	}
-	case arrayfile::ABINARY_DIFFZERO: {
-		//fwrite ( &index, 1, sizeof ( int32_t ), afile->nfid );
-		afile->write_array_binary_diffzero ( a );
+	case 8: {
+		const char *s = ( const char * ) src;
+		for ( int j=0; j<n; j++ )
+			array[j] = s[j];
 		break;
 	}
-	default
-			:
-		std::cout << "warning: arrayfile_t::append_array: no such mode " << afile->mode << std::endl;
+	case 32:
+		for ( int j=0; j<n; j++ ) {
+			int32_t v;
+			memcpy ( &v, src+4*j, sizeof ( int32_t ) );
+			array[j]=v;
+		}
 		break;
 	}
-	narraycounter++;
 }
 
-/// return true if file is open
-int arrayfile_t::isopen() const
+/// compress a block of arrays. if compression does not reduce the size the data is stored uncompressed
+static void compress_block ( const std::vector<unsigned char> &src, std::vector<unsigned char> &dst )
 {
 #ifdef USEZLIB
-	return ( this->nfid != 0 || this->gzfid != 0 );
-#else
-	return ( this->nfid != 0 );
+	uLongf n = compressBound ( src.size() );
+	dst.resize ( n );
+	if ( compress2 ( &dst[0], &n, &src[0], src.size(), Z_DEFAULT_COMPRESSION ) ==Z_OK && n<src.size() ) {
+		dst.resize ( n );
+		return;
+	}
 #endif
+	dst=src;
 }
 
-int arrayfile_t::append_arrays ( const arraylist_t& arrays, int startidx )
+/// decompress a block of arrays, return 0 on success
+static int uncompress_block ( const std::vector<unsigned char> &src, std::vector<unsigned char> &dst, size_t usize )
 {
-	arraylist_t::const_iterator	it;
-
-	assert ( this->nfid );
-
-	for ( it = arrays.begin(); it != arrays.end(); it++ ) {
-
-		//cout << "writing arrays in mode " << afile->mode << endl;
-
-		this->append_array ( *it, startidx );
-		startidx++;
+	if ( src.size() ==usize ) {
+		// block is stored uncompressed
+		dst=src;
+		return 0;
 	}
+#ifdef USEZLIB
+	dst.resize ( usize );
+	uLongf n = usize;
+	if ( uncompress ( &dst[0], &n, &src[0], src.size() ) !=Z_OK || n!=usize )
+		return 1;
 	return 0;
+#else
+	myprintf ( "uncompress_block: error: compressed blocks require zlib\n" );
+	return 1;
+#endif
 }
 
-arrayfile_t::arrayfile_t ( const std::string fname, int nrows, int ncols, int narrays, arrayfilemode_t m, int nb )
+bool arrayfile_t::isbinary() const
+{
+	return ( this->mode==ABINARY || this->mode==ABINARY_DIFF || this->mode==ABINARY_DIFFZERO || this->mode==ABINARY_BLOCK );
+}
+
+long long arrayfile_t::nbytes_encoded() const
+{
+	if ( this->mode==ABINARY_BLOCK )
+		return this->headersize() + ( long long ) std::max ( this->narraycounter, 0 ) *this->barraysize();
+	if ( this->nfid==0 )
+		return 0;
+	return std::max ( ftell ( this->nfid ), 0L );
+}
+
+void arrayfile_t::setBlocksize ( int n )
+{
+	if ( this->narraycounter>0 && this->rwmode==WRITE ) {
+		myprintf ( "arrayfile_t::setBlocksize: error: arrays have already been written\n" );
+		return;
+	}
+	if ( n<1 ) {
+		myprintf ( "arrayfile_t::setBlocksize: error: invalid block size %d\n", n );
+		return;
+	}
+	this->blocksize=n;
+}
+
+/// compress and write the blocks that are complete, the blocks are compressed in parallel
+void arrayfile_t::writependingblocks()
+{
+	const long nb = this->pendingblocks.size();
+	std::vector<std::vector<unsigned char> > cdata ( nb );
+#ifdef DOOPENMP
+	#pragma omp parallel for schedule(dynamic,1) if(nb>1)
+#endif
+	for ( long i=0; i<nb; i++ )
+		compress_block ( this->pendingblocks[i], cdata[i] );
+
+	for ( long i=0; i<nb; i++ ) {
+		arrayfile_blockinfo_t bi;
+		bi.offset = ftell ( this->nfid );
+		bi.csize = cdata[i].size();
+		bi.usize = this->pendingblocks[i].size();
+		size_t r = fwrite ( &cdata[i][0], 1, bi.csize, this->nfid );
+		if ( r!= ( size_t ) bi.csize )
+			myprintf ( "arrayfile_t::writependingblocks: error during write to file\n" );
+		this->blockindex.push_back ( bi );
+	}
+	this->pendingblocks.clear();
+}
+
+/// write the index of the blocks at the end of the file
+void arrayfile_t::writeblockindex()
+{
+	int64_t indexpos = ftell ( this->nfid );
+	for ( size_t i=0; i<this->blockindex.size(); i++ ) {
+		int64_t offset = this->blockindex[i].offset;
+		int32_t csize = this->blockindex[i].csize;
+		int32_t usize = this->blockindex[i].usize;
+		fwrite ( &offset, sizeof ( int64_t ), 1, this->nfid );
+		fwrite ( &csize, sizeof ( int32_t ), 1, this->nfid );
+		fwrite ( &usize, sizeof ( int32_t ), 1, this->nfid );
+	}
+	int32_t nblocks = this->blockindex.size();
+	int32_t magic = 1004;
+	fwrite ( &indexpos, sizeof ( int64_t ), 1, this->nfid );
+	fwrite ( &nblocks, sizeof ( int32_t ), 1, this->nfid );
+	fwrite ( &magic, sizeof ( int32_t ), 1, this->nfid );
+
+	// the block size can have been changed after the header was written
+	int32_t bs = this->blocksize;
+	fseek ( this->nfid, 6*sizeof ( int32_t ), SEEK_SET );
+	fwrite ( &bs, sizeof ( int32_t ), 1, this->nfid );
+	fseek ( this->nfid, 0, SEEK_END );
+}
+
+/// read the index of the blocks from the end of the file, return 0 on success
+int arrayfile_t::readblockindex()
+{
+	if ( this->nfid==0 )
+		return 1;
+	int64_t indexpos;
+	int32_t nblocks, magic;
+	if ( fseek ( this->nfid, - ( long ) ( sizeof ( int64_t ) +2*sizeof ( int32_t ) ), SEEK_END ) !=0 )
+		return 1;
+	if ( afread ( &indexpos, sizeof ( int64_t ), 1 ) !=1 || afread ( &nblocks, sizeof ( int32_t ), 1 ) !=1 || afread ( &magic, sizeof ( int32_t ), 1 ) !=1 )
+		return 1;
+	if ( magic!=1004 || nblocks<0 ) {
+		myprintf ( "arrayfile_t: error: no block index found in file %s\n", this->filename.c_str() );
+		return 1;
+	}
+	fseek ( this->nfid, indexpos, SEEK_SET );
+	this->blockindex.resize ( nblocks );
+	long na=0;
+	const int rs = this->barraysize();
+	for ( int i=0; i<nblocks; i++ ) {
+		int64_t offset;
+		int32_t csize, usize;
+		if ( afread ( &offset, sizeof ( int64_t ), 1 ) !=1 || afread ( &csize, sizeof ( int32_t ), 1 ) !=1 || afread ( &usize, sizeof ( int32_t ), 1 ) !=1 )
+			return 1;
+		this->blockindex[i].offset=offset;
+		this->blockindex[i].csize=csize;
+		this->blockindex[i].usize=usize;
+		na += usize/rs;
+	}
+	this->narrays = na;
+	this->currentblock=-1;
+	fseek ( this->nfid, this->headersize(), SEEK_SET );
+	return 0;
+}
+
+/// load a block into the block buffer, return 0 on success
+int arrayfile_t::loadblock ( long b )
+{
+	if ( b<0 || b>= ( long ) this->blockindex.size() )
+		return 1;
+	const arrayfile_blockinfo_t &bi = this->blockindex[b];
+	std::vector<unsigned char> cdata ( bi.csize );
+	fseek ( this->nfid, bi.offset, SEEK_SET );
+	if ( afread ( &cdata[0], 1, bi.csize ) != ( size_t ) bi.csize || uncompress_block ( cdata, this->blockdata, bi.usize ) ) {
+		myprintf ( "arrayfile_t::loadblock: error reading block %ld\n", b );
+		this->currentblock=-1;
+		return 1;
+	}
+	this->currentblock=b;
+	return 0;
+}
+
+/// return the data of the array at the current position in ABINARY_BLOCK format and advance the position, returns 0 at the end of the file
+const unsigned char *arrayfile_t::next_block_record ( int32_t &index )
+{
+	if ( this->narraycounter<0 || this->narraycounter>=this->narrays )
+		return 0;
+	const long b = this->narraycounter/this->blocksize;
+	if ( b!=this->currentblock ) {
+		if ( this->loadblock ( b ) )
+			return 0;
+	}
+	const unsigned char *p = &this->blockdata[0] + ( size_t ) ( this->narraycounter-b*this->blocksize ) *this->barraysize();
+	memcpy ( &index, p, sizeof ( int32_t ) );
+	this->narraycounter++;
+	if ( index==-1 )
+		index=0;
+	return p+sizeof ( int32_t );
+}
+
+/// read the array at the current position in ABINARY_BLOCK format and return the index
+int arrayfile_t::read_array_block ( array_t *array )
+{
+	int32_t index;
+	const unsigned char *p = this->next_block_record ( index );
+	if ( p==0 )
+		return -1;
+	decode_array_record ( p, this->nrows*this->ncols, this->nbits, array );
+	return index;
+}
+
+long arrayfile_t::read_arrays_block ( arraylist_t &arrays )
+{
+	if ( this->mode!=ABINARY_BLOCK ) {
+		myprintf ( "arrayfile_t::read_arrays_block: error: file is not in block format\n" );
+		return -1;
+	}
+	const long first = std::max ( this->narraycounter, 0 );
+	const long n = this->narrays-first;
+	if ( n<=0 )
+		return 0;
+	const long b0 = first/this->blocksize;
+	const long nb = this->blockindex.size();
+	const int rs = this->barraysize();
+
+	// reading from the file is sequential, decompression and decoding is done in parallel
+	std::vector<std::vector<unsigned char> > cdata ( nb-b0 );
+	for ( long b=b0; b<nb; b++ ) {
+		cdata[b-b0].resize ( this->blockindex[b].csize );
+		fseek ( this->nfid, this->blockindex[b].offset, SEEK_SET );
+		if ( afread ( &cdata[b-b0][0], 1, this->blockindex[b].csize ) != ( size_t ) this->blockindex[b].csize ) {
+			myprintf ( "arrayfile_t::read_arrays_block: error reading block %ld\n", b );
+			return -1;
+		}
+	}
+
+	const size_t start = arrays.size();
+	arrays.resize ( start+n );
+	for ( long i=0; i<n; i++ )
+		arrays[start+i].init ( this->nrows, this->ncols );
+
+	long nerrors=0;
+#ifdef DOOPENMP
+	#pragma omp parallel for schedule(dynamic,1) reduction(+:nerrors) if(nb-b0>1)
+#endif
+	for ( long b=b0; b<nb; b++ ) {
+		std::vector<unsigned char> data;
+		if ( uncompress_block ( cdata[b-b0], data, this->blockindex[b].usize ) ) {
+			nerrors++;
+			continue;
+		}
+		const long na = data.size() /rs;
+		for ( long j=0; j<na; j++ ) {
+			const long i = b*this->blocksize+j;
+			if ( i<first || i>=this->narrays )
+				continue;
+			array_link &al = arrays[start+i-first];
+			const unsigned char *p = &data[0]+j*rs;
+			int32_t index;
+			memcpy ( &index, p, sizeof ( int32_t ) );
+			decode_array_record ( p+sizeof ( int32_t ), this->nrows*this->ncols, this->nbits, al.array );
+			al.index = ( index==-1 ) ? 0 : index;
+		}
+	}
+	if ( nerrors>0 ) {
+		myprintf ( "arrayfile_t::read_arrays_block: error decompressing %ld blocks\n", nerrors );
+		arrays.resize ( start );
+		return -1;
+	}
+	this->narraycounter = this->narrays;
+	return n;
+}
+
+
+void arrayfile_t::append_array ( const array_link &a, int specialindex )
+{
+	int r;
+	if ( ! this->isopen() ) {
+		return;
+	}
+
+	arrayfile_t *afile = this;
+	int index;
+	if ( specialindex==-1 )
+		index=a.index;
+	else
+		index=specialindex;
+
+	switch ( afile->mode ) {
+	case arrayfile::ATEXT:
+		fprintf ( afile->nfid, "%i\n", index );
+		write_array ( afile->nfid, a.array, a.n_rows, a.n_columns );
+		break;
+	case arrayfile::ALATEX:
+		fprintf ( afile->nfid, "%i\n", index );
+		write_array_latex ( afile->nfid, a.array, a.n_rows, a.n_columns );
+		break;
+	case arrayfile::ABINARY: {
+		r = fwrite ( &index, 1, sizeof ( int32_t ), afile->nfid );
+		if ( r!=sizeof ( int32_t ) *1 ) {
+			printfd ( "error during write to file\n" );
+		}
+		//printf("   %d %d\n", a.n_rows, a.n_columns);
+		afile->write_array_binary ( a.array, a.n_rows, a.n_columns );
+		break;
+	}
+	case arrayfile::ABINARY_DIFF: {
+		fwrite ( &index, 1, sizeof ( int32_t ), afile->nfid );
+		afile->write_array_binary_diff ( a );
+		break;
+	}
+	case arrayfile::ABINARY_DIFFZERO: {
+		//fwrite ( &index, 1, sizeof ( int32_t ), afile->nfid );
+		afile->write_array_binary_diffzero ( a );
+		break;
+	}
+	case arrayfile::ABINARY_BLOCK: {
+		const size_t rs = this->barraysize();
+		const size_t pos = this->blockdata.size();
+		this->blockdata.resize ( pos+rs );
+		encode_array_record ( a.array, a.n_rows*a.n_columns, this->nbits, index, &this->blockdata[pos] );
+		if ( this->blockdata.size() >= this->blocksize*rs ) {
+			this->pendingblocks.push_back ( std::vector<unsigned char>() );
+			this->pendingblocks.back().swap ( this->blockdata );
+			if ( this->pendingblocks.size() >=16 )
+				this->writependingblocks();
+		}
+		break;
+	}
+	default
+			:
+		std::cout << "warning: arrayfile_t::append_array: no such mode " << afile->mode << std::endl;
+		break;
+	}
+	narraycounter++;
+}
+
+/// return true if file is open
+int arrayfile_t::isopen() const
+{
+#ifdef USEZLIB
+	return ( this->nfid != 0 || this->gzfid != 0 );
+#else
+	return ( this->nfid != 0 );
+#endif
+}
+
+int arrayfile_t::append_arrays ( const arraylist_t& arrays, int startidx )
+{
+	arraylist_t::const_iterator	it;
+
+	assert ( this->nfid );
+
+	for ( it = arrays.begin(); it != arrays.end(); it++ ) {
+
+		//cout << "writing arrays in mode " << afile->mode << endl;
+
+		this->append_array ( *it, startidx );
+		startidx++;
+	}
+	return 0;
+}
+
+arrayfile_t::arrayfile_t ( const std::string fname, int nrows, int ncols, int narrays, arrayfilemode_t m, int nb )
 {
 	//closefile();
 	this->verbose=0;
@@ -3041,6 +3839,8 @@ arrayfile_t::arrayfile_t ( const std::string fname, int nrows, int ncols, int na
 	this->narraycounter=-1;
 	this->rwmode=READ;
 	this->mode=ATEXT;
+	this->blocksize=4096;
+	this->currentblock=-1;
 
 #ifdef USEZLIB
 	this->gzfid=0;
@@ -3075,6 +3875,11 @@ size_t arrayfile_t::afread ( void * ptr, size_t sz, size_t cnt )
 
 int arrayfile_t::seek ( int pos )
 {
+	if ( mode==ABINARY_BLOCK && pos>=0 ) {
+		// the block containing the array is loaded on the next read
+		narraycounter = pos;
+		return pos;
+	}
 	if ( mode!= ABINARY ) {
 		myprintf ( "error: seek only possible for binary files\n" );
 		return -1;
@@ -3181,6 +3986,7 @@ int arrayfile_t::read_array ( array_link &a )
 		a.index = index;
 		break;
 	case arrayfile::ABINARY:
+	case arrayfile::ABINARY_BLOCK:
 		index = this->read_array ( a.array, a.n_rows, a.n_columns );
 		a.index = index;
 		break;
@@ -3232,6 +4038,43 @@ int arrayfile_t::read_array ( array_link &a )
 	return index;
 }
 
+int arrayfile_t::read_array ( packedarray_t &pa )
+{
+	int32_t index;
+	if ( this->nbits==1 && this->mode==arrayfile::ABINARY ) {
+		if ( afread ( &index, sizeof ( int32_t ), 1 ) !=1 ) {
+			if ( this->narrays!=-1 )
+				myprintf ( "arrayfile_t::read_array: error: could not read array index\n" );
+			pa.index=-1;
+			return -1;
+		}
+		if ( index==-1 )
+			index=0;	// -1 is invalid
+		const size_t nbytes = nwords ( this->nrows*this->ncols ) *sizeof ( word_t );
+		this->packedbuffer.resize ( nbytes );
+		if ( nbytes>0 && afread ( &this->packedbuffer[0], 1, nbytes ) !=nbytes ) {
+			myprintf ( "arrayfile_t::read_array: error: could not read array data\n" );
+			pa.index=-1;
+			return -1;
+		}
+		pa.setbitstream ( nbytes>0 ? &this->packedbuffer[0] : 0, this->nrows, this->ncols );
+	} else if ( this->nbits==1 && this->mode==arrayfile::ABINARY_BLOCK ) {
+		const unsigned char *p = this->next_block_record ( index );
+		if ( p==0 ) {
+			pa.index=-1;
+			return -1;
+		}
+		pa.setbitstream ( p, this->nrows, this->ncols );
+	} else {
+		array_link al ( this->nrows, this->ncols, array_link::INDEX_DEFAULT );
+		index = this->read_array ( al );
+		if ( index>=0 )
+			pa = packedarray_t ( al );
+	}
+	pa.index = index;
+	return index;
+}
+
 int arrayfile_t::read_array ( array_t* array, const int nrows, const int ncols )
 {
 	int index=-10;
@@ -3246,6 +4089,11 @@ int arrayfile_t::read_array ( array_t* array, const int nrows, const int ncols )
 	case arrayfile::ATEXT: {
 		int r = fscanf ( nfid, "%d\n", &index );
 		//myprintf("index %d\n", index);
+		if ( r!=1 || index==-1 ) {
+			// end of the list of arrays
+			index=-1;
+			break;
+		}
 		::read_array ( nfid, array, nrows, ncols );
 		break;
 	}
@@ -3265,6 +4113,9 @@ int arrayfile_t::read_array ( array_t* array, const int nrows, const int ncols )
 		this->read_array_binary ( array, nrows, ncols );
 	}
 	break;
+	case arrayfile::ABINARY_BLOCK:
+		index = this->read_array_block ( array );
+		break;
 	default
 			:
 		printf ( "arrayfile_t::read_array: error: no such mode %d\n", this->mode );
@@ -3279,7 +4130,7 @@ void arrayfile_t::writeheader()
 {
 	assert ( this->nfid );
 
-	if ( this->mode == arrayfile::ABINARY || this->mode == arrayfile::ABINARY_DIFF || this->mode == arrayfile::ABINARY_DIFFZERO ) {
+	if ( this->isbinary() ) {
 		//myprintf("  arrayfile_t::writeheader(): binary mode\n");
 		int magic=65;
 		int32_t reserved=0;
@@ -3301,15 +4152,26 @@ void arrayfile_t::writeheader()
 		else {
 			if ( this->mode == arrayfile::ABINARY_DIFF )
 				reserved=1002;
-			else
-				reserved=1003;
+			else {
+				if ( this->mode == arrayfile::ABINARY_BLOCK )
+					reserved=1004;
+				else
+					reserved=1003;
+			}
 		}
 		fwrite ( ( const void* ) & reserved,sizeof ( int ),1,this->nfid );
 		reserved=9999;
+		if ( this->mode == arrayfile::ABINARY_BLOCK )
+			reserved=this->blocksize;
 		fwrite ( ( const void* ) & reserved,sizeof ( int ),1,this->nfid );
+		reserved=9999;
 		fwrite ( ( const void* ) & reserved,sizeof ( int ),1,this->nfid );
 	} else {
-		fprintf ( this->nfid, "%i %i %i\n", this->ncols, this->nrows, this->narrays );
+		if ( this->narrays==-1 && this->rwmode==WRITE ) {
+			// reserve space for the number of arrays, the number is written when the file is closed
+			fprintf ( this->nfid, "%i %i %10i\n", this->ncols, this->nrows, this->narrays );
+		} else
+			fprintf ( this->nfid, "%i %i %i\n", this->ncols, this->nrows, this->narrays );
 	}
 }
 
@@ -3428,7 +4290,29 @@ int readarrayfile ( const char *fname, arraylist_t * arraylist, int verbose, col
 	if ( afile->narrays<0 )
 		narrays = arrayfile_t::NARRAYS_MAX;
 
-	array_link *alink;
+	if ( afile->mode==arrayfile::ABINARY_BLOCK ) {
+		long n = afile->read_arrays_block ( *arraylist );
+		delete afile;
+		return std::max ( n, 0L );
+	}
+
+	if ( afile->mode==arrayfile::ATEXT && afile->nfid!=0 ) {
+		long n = read_text_arrays ( afile->nfid, afile->nrows, afile->ncols, afile->narrays, *arraylist, verbose );
+		if ( n>=0 ) {
+			delete afile;
+			return n;
+		}
+		// fall back to reading the arrays one by one
+		fseek ( afile->nfid, 0, SEEK_SET );
+		int r = fscanf ( afile->nfid, "%i %i %i\n", &afile->ncols, &afile->nrows, &afile->narrays );
+		if ( r!=3 ) {
+			delete afile;
+			return 0;
+		}
+	}
+
+	// a single buffer is used for reading, the arrays are copied into the list
+	array_link alink ( afile->nrows, afile->ncols, 0 );
 	long i;
 	int index;
 	for ( i = 0; i < narrays; i++ ) {
@@ -3439,23 +4323,19 @@ int readarrayfile ( const char *fname, arraylist_t * arraylist, int verbose, col
 
 		if ( verbose>=3 )
 			myprintf ( "readarrayfile: i %ld\n", i );
-		alink = new array_link ( afile->nrows, afile->ncols, i+1 );
-		//index=afile->read_array ( alink->array, afile->nrows, afile->ncols );
-		index=afile->read_array ( *alink );
-		// myprintf("hack %d\n", index);
+		alink.index = i+1;
+		index=afile->read_array ( alink );
 
 		// NOTE: for array files we have used -1 to read arrays to the end of file,
 		if ( index<0 ) {
 			myprintf ( "readarrayfile: index %d, problem?\n", index );
-			delete alink;
 			break;
 
 		}
 		if ( verbose>=4 ) {
-			alink->showarray();
+			alink.showarray();
 		}
-		arraylist->push_back ( *alink );
-		delete alink;
+		arraylist->push_back ( alink );
 	}
 
 	delete afile;
@@ -3522,6 +4402,8 @@ arrayfile_t::arrayfile_t ()
 	this->ncols=0;
 	this->narrays=0;
 	this->narraycounter=0;
+	this->blocksize=4096;
+	this->currentblock=-1;
 
 }
 
@@ -3566,6 +4448,8 @@ arrayfile_t::arrayfile_t ( const std::string fnamein, int verbose )
 #endif
 
 	narraycounter=-1;	// make invalid
+	this->blocksize=4096;
+	this->currentblock=-1;
 
 	this->verbose=verbose;
 
@@ -3677,6 +4561,7 @@ arrayfile_t::arrayfile_t ( const std::string fnamein, int verbose )
 		result = afread ( &binary_mode,sizeof ( int32_t ),1 );
 		assert ( result==1 );
 		result = afread ( &reserved,sizeof ( int32_t ),1 );
+		int blockfield = reserved;
 		result = afread ( &reserved,sizeof ( int32_t ),1 );
 
 		//myprintf("arrayfile_t: constructor: binary_mode %d\n", binary_mode);
@@ -3691,6 +4576,10 @@ arrayfile_t::arrayfile_t ( const std::string fnamein, int verbose )
 		case 1003:
 			this->mode=arrayfile::ABINARY_DIFFZERO;
 			break;
+		case 1004:
+			this->mode=arrayfile::ABINARY_BLOCK;
+			this->blocksize=blockfield;
+			break;
 		case 0:
 			if ( verbose ) {
 				myprintf ( "  arrayfile_t::arrayfile_t: legacy file format, file %s!\n", this->filename.c_str() );
@@ -3713,6 +4602,15 @@ arrayfile_t::arrayfile_t ( const std::string fnamein, int verbose )
 
 		if ( result!=1 )
 			myprintf ( "open binary file: wrong count in afread! %d\n", result );
+
+		if ( this->mode == arrayfile::ABINARY_BLOCK ) {
+			if ( this->iscompressed || this->blocksize<1 || this->readblockindex() ) {
+				myprintf ( "arrayfile_t: error: cannot read block index of file %s\n", this->filename.c_str() );
+				this->mode=AERROR;
+				this->closefile();
+				return;
+			}
+		}
 	} else {
 		if ( iscompressed ) {
 			if ( verbose ) {
@@ -3723,6 +4621,8 @@ arrayfile_t::arrayfile_t ( const std::string fnamein, int verbose )
 			return;
 		} else {
 			this->nfid = fopen ( fname.c_str(), "rb" );
+			if ( this->nfid!=0 )
+				setvbuf ( this->nfid, 0, _IOFBF, 1<<16 );
 			this->gzfid=0;
 		}
 
@@ -3813,6 +4713,19 @@ void arrayfile_t::closefile()
 		myprintf ( "arrayfile_t::closefile: rwmode: %d\n", rwmode );
 	}
 
+	if ( this->mode==ABINARY_BLOCK && this->rwmode==WRITE && this->nfid!=0 ) {
+		// write the last block and the block index
+		if ( this->blockdata.size() >0 ) {
+			this->pendingblocks.push_back ( std::vector<unsigned char>() );
+			this->pendingblocks.back().swap ( this->blockdata );
+		}
+		this->writependingblocks();
+		this->writeblockindex();
+	}
+	this->blockindex.clear();
+	this->blockdata.clear();
+	this->currentblock=-1;
+
 	if ( narraycounter>=0 && narrays==-1 && ( this->rwmode==WRITE || this->rwmode==READWRITE ) && this->isbinary() ) {
 		if ( verbose>=2 )
 			myprintf ( "arrayfile_t: closing binary file, updating numbers %d->%d\n", narrays, narraycounter );
@@ -3830,6 +4743,16 @@ void arrayfile_t::closefile()
 		}
 
 	}
+	if ( narraycounter>=0 && narrays==-1 && this->rwmode==WRITE && ! this->isbinary() && nfid!=0 ) {
+		// the header of a text file has a fixed width field for the number of arrays
+		if ( verbose>=2 )
+			myprintf ( "arrayfile_t: closing text file, updating numbers %d->%d\n", narrays, narraycounter );
+		long pos = ftell ( nfid );
+		if ( fseek ( nfid, 0, SEEK_SET ) ==0 ) {
+			fprintf ( nfid, "%i %i %10i\n", this->ncols, this->nrows, narraycounter );
+			fseek ( nfid, pos, SEEK_SET );
+		}
+	}
 
 
 	// close file handles
@@ -4211,7 +5134,14 @@ void  selectArrays ( const std::string filename,   std::vector<int> &idx, arrayl
 {
 	arrayfile_t af ( filename, 0 );
 	array_link al ( af.nrows, af.ncols, -1 );
-	if ( af.mode==ABINARY ) {
+	if ( af.mode==ABINARY && ! af.iscompressed ) {
+		arrayfile_mmap_t mm ( filename, 0 );
+		if ( mm.isopen() ) {
+			mm.selectArrays ( idx, rl, verbose );
+			return;
+		}
+	}
+	if ( ( af.mode==ABINARY && ! af.iscompressed ) || af.mode==ABINARY_BLOCK ) {
 		for ( std::vector<int>::iterator it = idx.begin(); it<idx.end(); ++it ) {
 			if ( verbose )
 				printf ( "selectArrays: idx %d\n", *it );
@@ -4219,117 +5149,1465 @@ void  selectArrays ( const std::string filename,   std::vector<int> &idx, arrayl
 			af.read_array ( al );
 			rl.push_back ( al );
 		}
-	} else {
-		// check whether list is sorted
+		return;
+	}
+	if ( af.mode==ABINARY_DIFF || af.mode==ABINARY_DIFFZERO ) {
+		// the arrays depend on the previous array, read the file once up to the largest index
 		indexsort vv ( idx );
-		//vv.sortdescending(idx);
-
-		if ( vv.issorted() ) {
-			int cpos=0;
-			for ( std::vector<int>::iterator it = idx.begin(); it<idx.end(); ++it ) {
-				int pos =  *it;
-				if ( verbose )
-					printf ( "selectArrays: idx %d, cpos %d\n", pos, cpos );
-				if ( pos<cpos ) {
-					printf ( "selectArrays: arrayfile in text mode and negative seek, aborting!!! %d %d\n", pos, cpos );
-					// TODO: implement this
-					return;
-				}
-				int nsk=pos-cpos;
-				if ( verbose )
-					printf ( "selectArrays: skipping %d arrays\n", nsk );
-				for ( int j=0; j< ( nsk ); j++ )  {
-					af.read_array ( al );
-					if ( verbose>=3 ) {
-						std::vector<double> tmp = al.GWLP();
-						printf ( "  gwlp: " );
-						display_vector ( tmp );
-						printf ( "\n" );
-					}
-					cpos++;
-				}
-				af.read_array ( al );
-				cpos++;
-				rl.push_back ( al );
+		const size_t start = rl.size();
+		rl.resize ( start+idx.size() );
+		int cpos=0;
+		for ( size_t j=0; j<idx.size(); j++ ) {
+			const int pos = idx[vv.indices[j]];
+			if ( pos<0 || ( af.narrays>=0 && pos>=af.narrays ) ) {
+				myprintf ( "selectArrays: index %d out of range\n", pos );
+				rl[start+vv.indices[j]] = array_link ( af.nrows, af.ncols, -1 );
+				continue;
 			}
-		} else {
-			if ( verbose>=2 )
-				printf ( "selectArrays: text file with unsorted indices, UNTESTED CODE!\n" );
 			if ( verbose )
-				printf ( "selectArrays: no sorted indices!\n" );
-			if ( verbose>=2 ) {
-				cout << "idx: ";
-				display_vector<int> ( idx );
-				std::cout << std::endl;
-			}
-			// not sorted!
-			int nn=vv.indices.size();
-			std::vector<int> sidx = vv.sorted ( idx );
-			if ( verbose>=2 ) {
-				std::cout << "sidx: ";
-				display_vector<int> ( sidx );
-				std::cout << std::endl;
-			}
-			//vv.sortdescending(idx);
-			// std::vector<int> sidx2 = vv.sorted(idx);
-			//cout << "sidx2: "; display_vector<int>(sidx2); cout << endl;
-			arraylist_t tmp;
-			if ( verbose>=2 ) {
-				std::cout << "vv.indices: ";
-				display_vector<int> ( vv.indices );
-				std::cout << std::endl;
-			}
-			selectArrays ( filename,  sidx, tmp, 0 );
-			if ( ( int ) tmp.size() !=nn ) {
-				printf ( "ERROR!\n" );
-				return;
-			}
-			for ( int j=0; j<nn; j++ ) {
-				int x=vv.indices[j];
-				// TODO: or reverse entry?
-				rl.push_back ( tmp[x] );
-			}
+				printf ( "selectArrays: idx %d, cpos %d\n", pos, cpos );
+			for ( ; cpos<=pos; cpos++ )
+				af.read_array ( al );
+			rl[start+vv.indices[j]] = al;
 		}
+		return;
+	}
+
+	// text and compressed files: use the index with the positions of the arrays
+	arrayfile_index_t index ( filename, verbose );
+	if ( ! index.isvalid() ) {
+		myprintf ( "selectArrays: error: could not index file %s\n", filename.c_str() );
+		return;
 	}
+	index.selectArrays ( idx, rl, verbose );
 }
 
 array_link selectArrays ( const std::string filename, int ii )
 {
-	arrayfile_t af ( filename );
+	arrayfile_t af ( filename, 0 );
 	array_link al ( af.nrows, af.ncols, -1 );
 	if ( ii<0 ) {
 		myprintf ( "selectArrays: error: negative index\n" );
 		return al;
 	}
-	if ( af.mode==ABINARY ) {
+	if ( ( af.mode==ABINARY && ! af.iscompressed ) || af.mode==ABINARY_BLOCK ) {
 		af.seek ( ii );
 		af.read_array ( al );
 	} else {
-		for ( int i=0; i<ii; i++ )
-			af.read_array ( al );
-		af.read_array ( al );
+		std::vector<int> idx ( 1, ii );
+		arraylist_t rl;
+		selectArrays ( filename, idx, rl );
+		if ( rl.size() ==1 )
+			al = rl[0];
 	}
 	return al;
 }
 
-#endif // FULLPACKAGE, related to arrayfile_t
+arraystream_result_t filterArrayFile ( const std::string infile, const std::string outfile, const arraystream_filter_t &filter, arrayfile::arrayfilemode_t mode, int chunksize, int verbose )
+{
+	arraystream_result_t result;
+	result.nread=0;
+	result.nkept=0;
+
+	arrayfile_t af ( infile, verbose );
+	if ( ! af.isopen() ) {
+		myprintf ( "filterArrayFile: could not open file %s\n", infile.c_str() );
+		return result;
+	}
+	chunksize = std::max ( chunksize, 1 );
+	const long narrays = af.narrays;
 
+	// the buffers are allocated once and re-used for every chunk
+	arraylist_t chunk ( chunksize );
+	for ( int i=0; i<chunksize; i++ )
+		chunk[i].init ( af.nrows, af.ncols );
+	std::vector<char> keep ( chunksize );
 
-void  selectArrays ( const arraylist_t &al,   std::vector<int> &idx, arraylist_t &rl )
+	arraywriter_async_t *writer=0;
+	int nbits=8;
+	const double t0 = get_time_ms();
+	while ( 1 ) {
+		int n=0;
+		while ( n<chunksize && ( narrays<0 || result.nread<narrays ) ) {
+			if ( af.read_array ( chunk[n] ) <0 )
+				break;
+			n++;
+			result.nread++;
+		}
+		if ( n==0 )
+			break;
+
+#ifdef DOOPENMP
+		#pragma omp parallel for schedule(dynamic,16)
+#endif
+		for ( int i=0; i<n; i++ ) {
+			std::vector<double> p = filter.properties ( chunk[i] );
+			keep[i] = filter.keep ( chunk[i], p );
+		}
+
+		if ( writer==0 && outfile.size() >0 ) {
+			nbits = af.nbits;
+			if ( nbits<=0 ) {
+				// text file: the levels of later arrays are not known, so at least 8 bits are used
+				nbits = 8;
+				for ( int i=0; i<n; i++ )
+					nbits = std::max ( nbits, arrayfile_t::arrayNbits ( chunk[i] ) );
+			}
+			writer = new arraywriter_async_t ( outfile, af.nrows, af.ncols, mode, nbits, 2*chunksize );
+		}
+		bool nbitserror=false;
+		for ( int i=0; i<n; i++ ) {
+			if ( keep[i] ) {
+				if ( writer!=0 && af.nbits<=0 && arrayfile_t::arrayNbits ( chunk[i] ) >nbits ) {
+					myprintf ( "filterArrayFile: error: array %ld needs more than %d bits\n", result.nread-n+i, nbits );
+					nbitserror=true;
+					break;
+				}
+				if ( writer!=0 )
+					writer->append_array ( chunk[i] );
+				result.nkept++;
+			}
+		}
+		if ( verbose>=2 )
+			myprintf ( "filterArrayFile: %ld arrays read, %ld kept, %.1f [s]\n", result.nread, result.nkept, get_time_ms()-t0 );
+		if ( n<chunksize || nbitserror )
+			break;
+	}
+	if ( writer==0 && outfile.size() >0 ) {
+		// no arrays were read, create an empty file
+		writer = new arraywriter_async_t ( outfile, af.nrows, af.ncols, mode, ( af.nbits>0 ) ? af.nbits : 8, 2 );
+	}
+	if ( writer!=0 ) {
+		writer->close();
+		if ( verbose>=2 )
+			myprintf ( "filterArrayFile: %s\n", writer->showstr().c_str() );
+		delete writer;
+	}
+	if ( verbose )
+		myprintf ( "filterArrayFile: %s: %ld arrays read, %ld kept, %.1f [s]\n", infile.c_str(), result.nread, result.nkept, get_time_ms()-t0 );
+	return result;
+}
+
+/// return the number of bytes of the data of an array in binary format, or 0 if the number of bits is not supported
+static size_t binary_data_size ( int nbits, int nrows, int ncols )
 {
-	for ( std::vector<int>::iterator it = idx.begin(); it<idx.end(); it++ ) {
-		rl.push_back ( al.at ( *it ) );
+	switch ( nbits ) {
+	case 1:
+		return sizeof ( word_t ) *nwords ( nrows*ncols );
+	case 8:
+		return ( size_t ) nrows*ncols;
+	case 32:
+		return ( size_t ) 4*nrows*ncols;
+	default
+			:
+		return 0;
 	}
 }
-void  selectArrays ( const arraylist_t &al,   std::vector<long> &idx, arraylist_t &rl )
+
+#if defined(WIN32) || defined(_WIN32)
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ARRAYFILE_MMAP 1
+#endif
+
+arrayfile_mmap_t::arrayfile_mmap_t ( const std::string fnamein, int verbose ) : nrows ( 0 ), ncols ( 0 ), nbits ( 0 ), narrays ( 0 ), data ( 0 ), datasize ( 0 ), recordsize ( 0 ), mapped ( 0 )
 {
-	for ( std::vector<long>::iterator it = idx.begin(); it<idx.end(); it++ ) {
-		if ( ( *it ) >=0 && ( ( *it ) < ( int ) al.size() ) )
-			rl.push_back ( al.at ( *it ) );
-		else {
-			myprintf ( "selectArrays: index %ld out of bounds!\n", *it );
+	std::string fname = fnamein;
+	std::string gzname = fname+".gz";
+	if ( ! file_exists ( fname.c_str() ) && file_exists ( gzname.c_str() ) )
+		fname=gzname;
+	this->filename = fname;
+
+	bool iscompressed = fname.substr ( fname.find_last_of ( "." ) + 1 ) == "gz";
+
+#ifdef ARRAYFILE_MMAP
+	if ( ! iscompressed ) {
+		int fd = open ( fname.c_str(), O_RDONLY );
+		if ( fd<0 ) {
+			if ( verbose )
+				myprintf ( "arrayfile_mmap_t: problem opening file %s\n", fname.c_str() );
+			return;
 		}
+		struct stat sb;
+		if ( fstat ( fd, &sb ) ==0 && sb.st_size>0 ) {
+			void *p = mmap ( 0, sb.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+			if ( p!=MAP_FAILED ) {
+				this->data = ( const unsigned char * ) p;
+				this->datasize = sb.st_size;
+				this->mapped=1;
+#ifdef MADV_RANDOM
+				madvise ( p, sb.st_size, MADV_RANDOM );
+#endif
+			}
+		}
+		close ( fd );	// the mapping remains valid after closing the file descriptor
 	}
+#endif
+	if ( this->data==0 ) {
+		if ( this->loadbuffer ( fname ) ) {
+			if ( verbose )
+				myprintf ( "arrayfile_mmap_t: problem reading file %s\n", fname.c_str() );
+			this->closefile();
+			return;
+		}
+	}
+
+	if ( this->datasize < ( size_t ) this->headersize() ) {
+		if ( verbose )
+			myprintf ( "arrayfile_mmap_t: file %s is not a binary array file\n", fname.c_str() );
+		this->closefile();
+		return;
+	}
+
+	int32_t header[8];
+	memcpy ( header, this->data, sizeof ( header ) );
+	int binary_mode = header[5];
+	if ( header[0]!=65 || ( binary_mode!=1001 && binary_mode!=0 ) ) {
+		if ( verbose )
+			myprintf ( "arrayfile_mmap_t: file %s is not an array file in binary format (magic %d, mode %d)\n", fname.c_str(), header[0], binary_mode );
+		this->closefile();
+		return;
+	}
+	this->nbits=header[1];
+	this->nrows=header[2];
+	this->ncols=header[3];
+
+	size_t num = binary_data_size ( this->nbits, nrows, ncols );
+	if ( num==0 && nrows*ncols>0 ) {
+		myprintf ( "arrayfile_mmap_t: error: number of bits %d not supported\n", this->nbits );
+		this->closefile();
+		return;
+	}
+	this->recordsize = sizeof ( int32_t ) + num;
+
+	// the number of arrays in the header is -1 if it was unknown when the file was written
+	long nfile = ( this->datasize - this->headersize() ) / this->recordsize;
+	this->narrays = header[4];
+	if ( this->narrays<0 || this->narrays>nfile )
+		this->narrays = nfile;
+
+	if ( verbose>=2 )
+		myprintf ( "arrayfile_mmap_t: %s\n", this->showstr().c_str() );
+}
+
+arrayfile_mmap_t::~arrayfile_mmap_t()
+{
+	this->closefile();
+}
+
+void arrayfile_mmap_t::closefile()
+{
+#ifdef ARRAYFILE_MMAP
+	if ( this->mapped && this->data!=0 )
+		munmap ( ( void * ) this->data, this->datasize );
+#endif
+	this->data=0;
+	this->datasize=0;
+	this->mapped=0;
+	std::vector<unsigned char>().swap ( this->buffer );
+}
+
+/// read the complete file into the buffer, return 0 on success
+int arrayfile_mmap_t::loadbuffer ( const std::string &fname )
+{
+	const int chunk = 1<<20;
+#ifdef USEZLIB
+	gzFile gz = gzopen ( fname.c_str(), "rb" );
+	if ( gz==0 )
+		return 1;
+	while ( 1 ) {
+		size_t n = this->buffer.size();
+		this->buffer.resize ( n+chunk );
+		int r = gzread ( gz, &this->buffer[n], chunk );
+		if ( r<0 ) {
+			gzclose ( gz );
+			return 1;
+		}
+		this->buffer.resize ( n+r );
+		if ( r<chunk )
+			break;
+	}
+	gzclose ( gz );
+#else
+	if ( fname.substr ( fname.find_last_of ( "." ) + 1 ) == "gz" ) {
+		myprintf ( "arrayfile_mmap_t: cannot read compressed file %s without zlib\n", fname.c_str() );
+		return 1;
+	}
+	FILE *fid = fopen ( fname.c_str(), "rb" );
+	if ( fid==0 )
+		return 1;
+	while ( 1 ) {
+		size_t n = this->buffer.size();
+		this->buffer.resize ( n+chunk );
+		size_t r = fread ( &this->buffer[n], 1, chunk, fid );
+		this->buffer.resize ( n+r );
+		if ( r< ( size_t ) chunk )
+			break;
+	}
+	fclose ( fid );
+#endif
+	if ( this->buffer.size() ==0 )
+		return 1;
+	this->data = &this->buffer[0];
+	this->datasize = this->buffer.size();
+	return 0;
+}
+
+int arrayfile_mmap_t::arrayindex ( int i ) const
+{
+	if ( i<0 || i>=this->narrays )
+		return -1;
+	int32_t index;
+	memcpy ( &index, this->rawdata ( i ) - sizeof ( int32_t ), sizeof ( int32_t ) );
+	if ( index==-1 )
+		index=0;	// -1 is invalid, see arrayfile_t::read_array
+	return index;
+}
+
+int arrayfile_mmap_t::read_array ( int i, array_t *array ) const
+{
+	if ( i<0 || i>=this->narrays ) {
+		myprintf ( "arrayfile_mmap_t::read_array: index %d out of range (%d arrays)\n", i, this->narrays );
+		return -1;
+	}
+	decode_array_record ( this->rawdata ( i ), nrows*ncols, this->nbits, array );
+	return this->arrayindex ( i );
+}
+
+array_link arrayfile_mmap_t::getarray ( int i ) const
+{
+	array_link al ( this->nrows, this->ncols, -1 );
+	al.index = this->read_array ( i, al.array );
+	return al;
+}
+
+int arrayfile_mmap_t::read_array ( int i, packedarray_t &pa ) const
+{
+	if ( i<0 || i>=this->narrays ) {
+		myprintf ( "arrayfile_mmap_t::read_array: index %d out of range (%d arrays)\n", i, this->narrays );
+		return -1;
+	}
+	if ( this->nbits==1 )
+		pa.setbitstream ( this->rawdata ( i ), this->nrows, this->ncols );
+	else
+		pa = packedarray_t ( this->getarray ( i ) );
+	pa.index = this->arrayindex ( i );
+	return pa.index;
+}
+
+void arrayfile_mmap_t::selectArrays ( const std::vector<int> &idx, arraylist_t &rl, int verbose ) const
+{
+	const size_t start = rl.size();
+	const long n = idx.size();
+	rl.resize ( start+n );
+	for ( long i=0; i<n; i++ )
+		rl[start+i].init ( this->nrows, this->ncols );
+
+#ifdef DOOPENMP
+	#pragma omp parallel for schedule(dynamic,256) if(n>1000)
+#endif
+	for ( long i=0; i<n; i++ ) {
+		array_link &al = rl[start+i];
+		if ( verbose>=2 ) {
+#ifdef DOOPENMP
+			#pragma omp critical
+#endif
+			myprintf ( "arrayfile_mmap_t::selectArrays: idx %d\n", idx[i] );
+		}
+		al.index = this->read_array ( idx[i], al.array );
+	}
+}
+
+#include <sys/stat.h>
+
+/// get the size and modification time of a file, returns 0 on success
+static int file_stat ( const std::string &fname, int64_t &size, int64_t &mtime )
+{
+	struct stat sb;
+	if ( stat ( fname.c_str(), &sb ) !=0 )
+		return 1;
+	size = sb.st_size;
+	mtime = sb.st_mtime;
+	return 0;
+}
+
+/// seek to a 64-bit position in a file, returns 0 on success
+static int fseek64 ( FILE *fid, int64_t offset )
+{
+#if defined(WIN32) || defined(_WIN32)
+	return _fseeki64 ( fid, offset, SEEK_SET );
+#else
+	return fseeko ( fid, ( off_t ) offset, SEEK_SET );
+#endif
+}
+
+/** @brief Find the arrays in the uncompressed data of an array file
+ *
+ * The data is passed in chunks. For text files the line structure is followed: a header line, then for each array a
+ * line with the index and one line per row, until a line with index -1. For binary files the header is stored and the
+ * offsets follow from the size of the records.
+ */
+struct arrayfile_scanner_t {
+	enum {HEADER, INDEXLINE, ROWS, DONE};
+	/// -1 if the format is not known yet, 0 for text files and 1 for binary files
+	int isbinary;
+	int64_t pos;
+	int state;
+	int linesleft;
+	int64_t linestart;
+	std::string line;
+	std::vector<unsigned char> head;
+	int nrows;
+	int ncols;
+	int nbits;
+	int error;
+	std::vector<int64_t> offsets;
+
+	arrayfile_scanner_t() : isbinary ( -1 ), pos ( 0 ), state ( HEADER ), linesleft ( 0 ), linestart ( 0 ), nrows ( 0 ), ncols ( 0 ), nbits ( 0 ), error ( 0 ) {}
+
+	void feed ( const unsigned char *p, size_t n ) {
+		if ( isbinary<0 ) {
+			while ( n>0 && head.size() <sizeof ( int32_t ) ) {
+				head.push_back ( *p++ );
+				n--;
+			}
+			if ( head.size() <sizeof ( int32_t ) )
+				return;
+			int32_t magic;
+			memcpy ( &magic, &head[0], sizeof ( int32_t ) );
+			isbinary = magic==65;
+			if ( ! isbinary ) {
+				std::vector<unsigned char> tmp ( head );
+				head.clear();
+				this->feedtext ( ( const char * ) &tmp[0], tmp.size() );
+			} else {
+				pos = head.size();
+			}
+		}
+		if ( isbinary ) {
+			const size_t headersize = 8*sizeof ( int32_t );
+			for ( size_t i=0; i<n && head.size() <headersize; i++ )
+				head.push_back ( p[i] );
+			pos += n;
+		} else
+			this->feedtext ( ( const char * ) p, n );
+	}
+
+	/// determine the offsets of the arrays after all data has been passed, returns 0 on success
+	int finish() {
+		if ( isbinary==1 )
+			return this->finishbinary();
+		if ( isbinary<0 || error || state==HEADER )
+			return 1;
+
+		int64_t end = linestart;
+		if ( state==ROWS ) {
+			// the last line of an array does not need to end with a newline
+			if ( linesleft==1 && pos>linestart ) {
+				end = pos;
+			} else {
+				end = offsets.back();
+				offsets.pop_back();
+			}
+		}
+		if ( state!=DONE )
+			offsets.push_back ( end );
+		return 0;
+	}
+
+private:
+	void feedtext ( const char *p, size_t n ) {
+		const char *end = p+n;
+		while ( p<end && state!=DONE ) {
+			const char *q = ( const char * ) memchr ( p, '\n', end-p );
+			if ( state==ROWS ) {
+				if ( q==0 ) {
+					pos += end-p;
+					break;
+				}
+				pos += q+1-p;
+				p = q+1;
+				linestart=pos;
+				linesleft--;
+				if ( linesleft==0 )
+					state=INDEXLINE;
+				continue;
+			}
+			const char *e = q ? q : end;
+			if ( line.size() <256 )
+				line.append ( p, std::min<size_t> ( e-p, 256 ) );
+			pos += e-p;
+			p=e;
+			if ( q ) {
+				p++;
+				pos++;
+				this->endline();
+			}
+		}
+	}
+
+	void endline() {
+		if ( state==HEADER ) {
+			int narrays;
+			if ( sscanf ( line.c_str(), "%d %d %d", &ncols, &nrows, &narrays ) !=3 || nrows<0 || ncols<0 )
+				error=1;
+			state = error ? DONE : INDEXLINE;
+		} else {
+			int index;
+			const char *p = line.c_str();
+			if ( parse_int ( p, p+line.size(), index ) ==0 || index==-1 ) {
+				offsets.push_back ( linestart );
+				state=DONE;
+			} else {
+				offsets.push_back ( linestart );
+				linesleft=nrows;
+				state = nrows>0 ? ROWS : INDEXLINE;
+			}
+		}
+		line.clear();
+		linestart=pos;
+	}
+
+	int finishbinary() {
+		if ( head.size() <8*sizeof ( int32_t ) )
+			return 1;
+		int32_t header[8];
+		memcpy ( header, &head[0], sizeof ( header ) );
+		if ( header[5]!=1001 && header[5]!=0 ) {
+			myprintf ( "arrayfile_index_t: binary files with mode %d cannot be indexed\n", header[5] );
+			return 1;
+		}
+		nbits = header[1];
+		nrows = header[2];
+		ncols = header[3];
+		const int64_t recordsize = sizeof ( int32_t ) + binary_data_size ( nbits, nrows, ncols );
+		if ( recordsize==sizeof ( int32_t ) && nrows*ncols>0 )
+			return 1;
+		int64_t n = ( pos-head.size() ) /recordsize;
+		if ( header[4]>=0 && header[4]<n )
+			n = header[4];
+		for ( int64_t i=0; i<=n; i++ )
+			offsets.push_back ( head.size() + i*recordsize );
+		return 0;
+	}
+};
+
+#ifdef USEZLIB
+#define ARRAYINDEX_SPAN 1048576L
+#define ARRAYINDEX_WINSIZE 32768U
+#define ARRAYINDEX_CHUNK 16384
+
+/// add an access point, the window contains the last ARRAYINDEX_WINSIZE bytes of output in circular order
+static void add_accesspoint ( std::vector<arrayfile_accesspoint_t> &points, int bits, int64_t in, int64_t out, unsigned left, const unsigned char *window )
+{
+	arrayfile_accesspoint_t point;
+	point.bits = bits;
+	point.coffset = in;
+	point.uoffset = out;
+	point.window.resize ( ARRAYINDEX_WINSIZE );
+	if ( left )
+		memcpy ( &point.window[0], window + ARRAYINDEX_WINSIZE - left, left );
+	if ( left < ARRAYINDEX_WINSIZE )
+		memcpy ( &point.window[left], window, ARRAYINDEX_WINSIZE - left );
+	points.push_back ( point );
+}
+
+/// decompress a file, pass the data to the scanner and create access points at deflate block boundaries. returns 0 on success
+static int scan_compressed ( FILE *fid, arrayfile_scanner_t &scanner, std::vector<arrayfile_accesspoint_t> &points )
+{
+	z_stream strm;
+	strm.zalloc = Z_NULL;
+	strm.zfree = Z_NULL;
+	strm.opaque = Z_NULL;
+	strm.avail_in = 0;
+	strm.next_in = Z_NULL;
+	if ( inflateInit2 ( &strm, 47 ) !=Z_OK )	// gzip or zlib format
+		return 1;
+
+	std::vector<unsigned char> input ( ARRAYINDEX_CHUNK );
+	std::vector<unsigned char> window ( ARRAYINDEX_WINSIZE, 0 );
+	int64_t totin=0, totout=0, last=0;
+	int ret=Z_OK;
+	strm.avail_out = 0;
+	do {
+		strm.avail_in = fread ( &input[0], 1, ARRAYINDEX_CHUNK, fid );
+		if ( strm.avail_in==0 ) {
+			ret = Z_DATA_ERROR;
+			break;
+		}
+		strm.next_in = &input[0];
+		do {
+			if ( strm.avail_out==0 ) {
+				strm.avail_out = ARRAYINDEX_WINSIZE;
+				strm.next_out = &window[0];
+			}
+			unsigned char *out0 = strm.next_out;
+			totin += strm.avail_in;
+			totout += strm.avail_out;
+			ret = inflate ( &strm, Z_BLOCK );
+			totin -= strm.avail_in;
+			totout -= strm.avail_out;
+			if ( ret==Z_NEED_DICT || ret==Z_MEM_ERROR || ret==Z_DATA_ERROR ) {
+				ret = Z_DATA_ERROR;
+				break;
+			}
+			scanner.feed ( out0, strm.next_out-out0 );
+			if ( ret==Z_STREAM_END )
+				break;
+			// access points are created at the end of the header and at block boundaries, except after the last block
+			if ( ( strm.data_type & 128 ) && ! ( strm.data_type & 64 ) && ( totout==0 || totout-last>ARRAYINDEX_SPAN ) ) {
+				add_accesspoint ( points, strm.data_type & 7, totin, totout, strm.avail_out, &window[0] );
+				last = totout;
+			}
+		} while ( strm.avail_in!=0 );
+	} while ( ret!=Z_STREAM_END && ret!=Z_DATA_ERROR );
+	inflateEnd ( &strm );
+	return ret!=Z_STREAM_END;
+}
+#endif
+
+namespace arrayfile
+{
+
+/// reader for the uncompressed data of an indexed array file, reading forward from the current position is efficient
+class arrayfile_indexreader_t
+{
+public:
+	arrayfile_indexreader_t ( const arrayfile_index_t &index_ ) : index ( index_ ) {
+		this->fid = fopen ( index.filename.c_str(), "rb" );
+#ifdef USEZLIB
+		this->active=0;
+		this->upos=0;
+#endif
+	}
+	~arrayfile_indexreader_t() {
+		if ( fid )
+			fclose ( fid );
+#ifdef USEZLIB
+		if ( active )
+			inflateEnd ( &strm );
+#endif
+	}
+
+	/// read n bytes of uncompressed data at the specified offset, returns 0 on success
+	int read ( int64_t offset, size_t n, unsigned char *buffer ) {
+		if ( fid==0 )
+			return 1;
+		if ( ! index.iscompressed ) {
+			if ( fseek64 ( fid, offset ) )
+				return 1;
+			return fread ( buffer, 1, n, fid ) !=n;
+		}
+#ifdef USEZLIB
+		// start at the last access point before the offset, unless the current position is closer
+		const std::vector<arrayfile_accesspoint_t> &points = index.accesspoints;
+		size_t a=0;
+		while ( a+1<points.size() && points[a+1].uoffset<=offset )
+			a++;
+		if ( points.size() ==0 )
+			return 1;
+		if ( ! active || offset<upos || points[a].uoffset>upos ) {
+			if ( this->restart ( points[a] ) )
+				return 1;
+		}
+		std::vector<unsigned char> discard;
+		while ( upos<offset ) {
+			size_t m = std::min<int64_t> ( offset-upos, ARRAYINDEX_WINSIZE );
+			discard.resize ( m );
+			if ( this->inflateto ( &discard[0], m ) )
+				return 1;
+		}
+		return this->inflateto ( buffer, n );
+#else
+		return 1;
+#endif
+	}
+
+private:
+	const arrayfile_index_t &index;
+	FILE *fid;
+#ifdef USEZLIB
+	z_stream strm;
+	int active;
+	/// position in the uncompressed data
+	int64_t upos;
+	unsigned char input[ARRAYINDEX_CHUNK];
+
+	int restart ( const arrayfile_accesspoint_t &point ) {
+		if ( active )
+			inflateEnd ( &strm );
+		active=0;
+		strm.zalloc = Z_NULL;
+		strm.zfree = Z_NULL;
+		strm.opaque = Z_NULL;
+		strm.avail_in = 0;
+		strm.next_in = Z_NULL;
+		if ( inflateInit2 ( &strm, -15 ) !=Z_OK )	// raw inflate
+			return 1;
+		active=1;
+		if ( fseek64 ( fid, point.coffset - ( point.bits ? 1 : 0 ) ) )
+			return 1;
+		if ( point.bits ) {
+			int c = getc ( fid );
+			if ( c==EOF )
+				return 1;
+			inflatePrime ( &strm, point.bits, c >> ( 8-point.bits ) );
+		}
+		inflateSetDictionary ( &strm, &point.window[0], point.window.size() );
+		upos = point.uoffset;
+		return 0;
+	}
+
+	int inflateto ( unsigned char *out, size_t n ) {
+		strm.next_out = out;
+		strm.avail_out = n;
+		while ( strm.avail_out>0 ) {
+			if ( strm.avail_in==0 ) {
+				strm.avail_in = fread ( input, 1, ARRAYINDEX_CHUNK, fid );
+				if ( strm.avail_in==0 )
+					return 1;
+				strm.next_in = input;
+			}
+			int ret = inflate ( &strm, Z_NO_FLUSH );
+			if ( ret==Z_NEED_DICT || ret==Z_MEM_ERROR || ret==Z_DATA_ERROR )
+				return 1;
+			if ( ret==Z_STREAM_END && strm.avail_out>0 )
+				return 1;
+		}
+		upos += n;
+		return 0;
+	}
+#endif
+
+	arrayfile_indexreader_t ( const arrayfile_indexreader_t & );
+	arrayfile_indexreader_t &operator= ( const arrayfile_indexreader_t & );
+};
+
+} // end of namespace
+
+arrayfile_index_t::arrayfile_index_t ( const std::string fnamein, int verbose ) : nrows ( 0 ), ncols ( 0 ), nbits ( 0 ), narrays ( -1 ), iscompressed ( 0 ), filesize ( 0 ), filetime ( 0 )
+{
+	std::string fname = fnamein;
+	std::string gzname = fname+".gz";
+	if ( ! file_exists ( fname.c_str() ) && file_exists ( gzname.c_str() ) )
+		fname=gzname;
+	this->filename = fname;
+	this->iscompressed = fname.substr ( fname.find_last_of ( "." ) + 1 ) == "gz";
+
+	if ( file_stat ( fname, this->filesize, this->filetime ) ) {
+		if ( verbose )
+			myprintf ( "arrayfile_index_t: problem opening file %s\n", fname.c_str() );
+		return;
+	}
+
+	const std::string indexfile = indexfilename ( fname );
+	if ( this->load ( indexfile ) ==0 ) {
+		if ( verbose>=2 )
+			myprintf ( "arrayfile_index_t: loaded index %s\n", indexfile.c_str() );
+		return;
+	}
+
+	double t0 = get_time_ms();
+	if ( this->build ( verbose ) ) {
+		if ( verbose )
+			myprintf ( "arrayfile_index_t: could not create index of file %s\n", fname.c_str() );
+		this->narrays=-1;
+		this->offsets.clear();
+		this->accesspoints.clear();
+		return;
+	}
+	if ( verbose>=2 )
+		myprintf ( "arrayfile_index_t: indexed %d arrays in %.1f [s]\n", this->narrays, get_time_ms()-t0 );
+	if ( this->save ( indexfile ) && verbose )
+		myprintf ( "arrayfile_index_t: could not write index file %s\n", indexfile.c_str() );
+}
+
+int arrayfile_index_t::build ( int verbose )
+{
+	FILE *fid = fopen ( this->filename.c_str(), "rb" );
+	if ( fid==0 )
+		return 1;
+
+	arrayfile_scanner_t scanner;
+	int error=0;
+	if ( this->iscompressed ) {
+#ifdef USEZLIB
+		error = scan_compressed ( fid, scanner, this->accesspoints );
+#else
+		myprintf ( "arrayfile_index_t: error: compressed files require zlib\n" );
+		error=1;
+#endif
+	} else {
+		std::vector<unsigned char> buffer ( 1<<20 );
+		while ( 1 ) {
+			size_t r = fread ( &buffer[0], 1, buffer.size(), fid );
+			scanner.feed ( &buffer[0], r );
+			if ( r<buffer.size() )
+				break;
+		}
+	}
+	fclose ( fid );
+	if ( error || scanner.finish() )
+		return 1;
+
+	this->nrows = scanner.nrows;
+	this->ncols = scanner.ncols;
+	this->nbits = scanner.nbits;
+	this->offsets.swap ( scanner.offsets );
+	this->narrays = this->offsets.size()-1;
+	return 0;
+}
+
+int arrayfile_index_t::save ( const std::string &indexfile ) const
+{
+	FILE *fid = fopen ( indexfile.c_str(), "wb" );
+	if ( fid==0 )
+		return 1;
+	int32_t header[8] = {66, 1, iscompressed, nbits, nrows, ncols, narrays, ( int32_t ) accesspoints.size() };
+	int64_t stamp[2] = {filesize, filetime};
+	size_t nw = fwrite ( header, sizeof ( int32_t ), 8, fid ) + fwrite ( stamp, sizeof ( int64_t ), 2, fid );
+	nw += fwrite ( &offsets[0], sizeof ( int64_t ), offsets.size(), fid );
+	int error = nw!=10+offsets.size();
+	for ( size_t i=0; i<accesspoints.size(); i++ ) {
+		const arrayfile_accesspoint_t &point = accesspoints[i];
+		int64_t pos[2] = {point.uoffset, point.coffset};
+		int32_t info[2] = {point.bits, ( int32_t ) point.window.size() };
+		if ( fwrite ( pos, sizeof ( int64_t ), 2, fid ) !=2 || fwrite ( info, sizeof ( int32_t ), 2, fid ) !=2 || fwrite ( &point.window[0], 1, point.window.size(), fid ) !=point.window.size() )
+			error=1;
+	}
+	if ( fclose ( fid ) )
+		error=1;
+	if ( error )
+		remove ( indexfile.c_str() );
+	return error;
+}
+
+int arrayfile_index_t::load ( const std::string &indexfile )
+{
+	FILE *fid = fopen ( indexfile.c_str(), "rb" );
+	if ( fid==0 )
+		return 1;
+	int32_t header[8];
+	int64_t stamp[2];
+	int error = fread ( header, sizeof ( int32_t ), 8, fid ) !=8 || fread ( stamp, sizeof ( int64_t ), 2, fid ) !=2;
+	// the index is only valid for the same version of the array file
+	if ( error || header[0]!=66 || header[1]!=1 || header[2]!=this->iscompressed || header[6]<0 || header[7]<0 || stamp[0]!=this->filesize || stamp[1]!=this->filetime ) {
+		fclose ( fid );
+		return 1;
+	}
+	this->offsets.resize ( header[6]+1 );
+	if ( fread ( &this->offsets[0], sizeof ( int64_t ), offsets.size(), fid ) !=offsets.size() )
+		error=1;
+	this->accesspoints.resize ( header[7] );
+	for ( int i=0; i<header[7] && !error; i++ ) {
+		arrayfile_accesspoint_t &point = this->accesspoints[i];
+		int64_t pos[2];
+		int32_t info[2];
+		if ( fread ( pos, sizeof ( int64_t ), 2, fid ) !=2 || fread ( info, sizeof ( int32_t ), 2, fid ) !=2 || info[1]<0 ) {
+			error=1;
+			break;
+		}
+		point.uoffset=pos[0];
+		point.coffset=pos[1];
+		point.bits=info[0];
+		point.window.resize ( info[1] );
+		if ( info[1]>0 && fread ( &point.window[0], 1, info[1], fid ) != ( size_t ) info[1] )
+			error=1;
+	}
+	fclose ( fid );
+	if ( error ) {
+		this->offsets.clear();
+		this->accesspoints.clear();
+		return 1;
+	}
+	this->nbits=header[3];
+	this->nrows=header[4];
+	this->ncols=header[5];
+	this->narrays=header[6];
+	return 0;
+}
+
+void arrayfile_index_t::readarrays ( const std::vector<int> &idx, const std::vector<long> &order, long i0, long i1, arraylist_t &rl, size_t start ) const
+{
+	arrayfile_indexreader_t reader ( *this );
+	std::vector<unsigned char> buffer;
+	const int n = nrows*ncols;
+	for ( long i=i0; i<i1; i++ ) {
+		const long j = order[i];
+		const int pos = idx[j];
+		array_link &al = rl[start+j];
+		if ( pos<0 || pos>=this->narrays ) {
+			myprintf ( "arrayfile_index_t::selectArrays: index %d out of range (%d arrays)\n", pos, this->narrays );
+			al.index=-1;
+			continue;
+		}
+		if ( i>i0 && idx[order[i-1]]==pos ) {
+			// repeated index
+			al = rl[start+order[i-1]];
+			continue;
+		}
+		const size_t size = this->offsets[pos+1]-this->offsets[pos];
+		buffer.resize ( size+1 );
+		if ( reader.read ( this->offsets[pos], size, &buffer[0] ) ) {
+			myprintf ( "arrayfile_index_t::selectArrays: error reading array %d from %s\n", pos, filename.c_str() );
+			al.index=-1;
+			continue;
+		}
+		if ( this->nbits==0 ) {
+			al.index = parse_text_array ( ( const char * ) &buffer[0], ( const char * ) &buffer[0]+size, al.array, nrows, ncols );
+		} else {
+			int32_t index;
+			memcpy ( &index, &buffer[0], sizeof ( int32_t ) );
+			decode_array_record ( &buffer[0]+sizeof ( int32_t ), n, this->nbits, al.array );
+			al.index = index==-1 ? 0 : index;	// -1 is invalid, see arrayfile_t::read_array
+		}
+	}
+}
+
+void arrayfile_index_t::selectArrays ( const std::vector<int> &idx, arraylist_t &rl, int verbose ) const
+{
+	const size_t start = rl.size();
+	const long n = idx.size();
+	rl.resize ( start+n );
+	for ( long i=0; i<n; i++ )
+		rl[start+i].init ( this->nrows, this->ncols );
+
+	// read the arrays in order of their position in the file, so the reader only moves forward
+	std::vector<long> order ( n );
+	indexsort sorter ( idx );
+	for ( long i=0; i<n; i++ )
+		order[i] = sorter.indices[i];
+
+	if ( verbose>=2 )
+		myprintf ( "arrayfile_index_t::selectArrays: reading %ld arrays from %s\n", n, filename.c_str() );
+
+#ifdef DOOPENMP
+	#pragma omp parallel if(n>256)
+	{
+		const long nt = omp_get_num_threads();
+		const long t = omp_get_thread_num();
+		this->readarrays ( idx, order, ( n*t ) /nt, ( n* ( t+1 ) ) /nt, rl, start );
+	}
+#else
+	this->readarrays ( idx, order, 0, n, rl, start );
+#endif
+}
+
+array_link arrayfile_index_t::getarray ( int i ) const
+{
+	arraylist_t rl;
+	this->selectArrays ( std::vector<int> ( 1, i ), rl );
+	return rl[0];
+}
+
+#if __cplusplus >= 201103L
+#include <atomic>
+#include <thread>
+#include <chrono>
+#define ARRAYWRITER_ASYNC 1
+#endif
+
+namespace arrayfile
+{
+
+/// internal state of the asynchronous array writer
+struct arraywriter_state_t {
+	arrayfile_t afile;
+	double flushinterval;
+#ifdef ARRAYWRITER_ASYNC
+	/// element of the ring buffer, the sequence number determines whether the element can be written or read
+	struct cell_t {
+		std::atomic<size_t> sequence;
+		array_link al;
+	};
+	cell_t *cells;
+	size_t mask;
+	std::atomic<size_t> enqueuepos;
+	size_t dequeuepos;	// only used by the writer thread
+
+	std::atomic<long> nadded;
+	std::atomic<long> nwritten;
+	std::atomic<long> nwaits;
+	std::atomic<long long> nbytes;
+	std::atomic<long long> writetime_us;
+	std::atomic<bool> stop;
+	std::atomic<bool> flushrequest;
+	std::thread worker;
+#else
+	long nadded;
+	long nwritten;
+	long nwaits;
+	long long nbytes;
+	double writetime;
+	double lastflush;
+#endif
+};
+
+#ifdef ARRAYWRITER_ASYNC
+/// background thread of the asynchronous writer: write arrays from the ring buffer in batches
+static void arraywriter_worker ( arraywriter_state_t *st )
+{
+	const int batchmax = 256;
+	double lastflush = get_time_ms();
+	bool dirty=false;	// arrays have been written since the last flush
+	while ( 1 ) {
+		const double t0 = get_time_ms();
+		int n=0;
+		while ( n<batchmax ) {
+			arraywriter_state_t::cell_t &c = st->cells[st->dequeuepos & st->mask];
+			if ( c.sequence.load ( std::memory_order_acquire ) != st->dequeuepos+1 )
+				break;
+			st->afile.append_array ( c.al );
+			c.sequence.store ( st->dequeuepos+st->mask+1, std::memory_order_release );
+			st->dequeuepos++;
+			n++;
+		}
+		const double t1 = get_time_ms();
+		if ( n>0 )
+			dirty=true;
+		bool flushed=false;
+		if ( ( dirty && t1-lastflush>st->flushinterval ) || st->flushrequest.load() ) {
+			fflush ( st->afile.nfid );
+			lastflush=t1;
+			dirty=false;
+			flushed=true;
+		}
+		if ( n>0 || flushed ) {
+			st->nwritten += n;
+			st->nbytes = st->afile.nbytes_encoded();
+			st->writetime_us += ( long long ) ( 1e6* ( get_time_ms()-t0 ) );
+		}
+		if ( flushed )
+			st->flushrequest=false;
+		if ( n==0 ) {
+			if ( st->stop.load() && st->nwritten.load() ==st->nadded.load() )
+				break;
+			std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+		}
+	}
+}
+#endif
+
+}
+
+arraywriter_async_t::arraywriter_async_t ( const std::string fname, int nrows, int ncols, arrayfilemode_t mode, int nbits, int capacity, double flushinterval )
+{
+	this->state = new arraywriter_state_t();
+	arraywriter_state_t *st = this->state;
+	st->flushinterval = flushinterval;
+	st->nadded=0;
+	st->nwritten=0;
+	st->nwaits=0;
+	st->afile.createfile ( fname, nrows, ncols, -1, mode, nbits );
+	st->nbytes=st->afile.nbytes_encoded();
+#ifdef ARRAYWRITER_ASYNC
+	size_t n=1;
+	while ( n< ( size_t ) std::max ( capacity, 2 ) )
+		n*=2;
+	st->cells = new arraywriter_state_t::cell_t[n];
+	for ( size_t i=0; i<n; i++ )
+		st->cells[i].sequence.store ( i );
+	st->mask = n-1;
+	st->enqueuepos=0;
+	st->dequeuepos=0;
+	st->writetime_us=0;
+	st->stop=false;
+	st->flushrequest=false;
+	if ( st->afile.isopen() )
+		st->worker = std::thread ( arraywriter_worker, st );
+#else
+	st->writetime=0;
+	st->lastflush=get_time_ms();
+#endif
+}
+
+arraywriter_async_t::~arraywriter_async_t()
+{
+	this->close();
+#ifdef ARRAYWRITER_ASYNC
+	delete [] this->state->cells;
+#endif
+	delete this->state;
+}
+
+bool arraywriter_async_t::isopen() const
+{
+	return this->state->afile.isopen();
+}
+
+void arraywriter_async_t::append_array ( const array_link &al )
+{
+	arraywriter_state_t *st = this->state;
+	if ( ! st->afile.isopen() ) {
+		myprintf ( "arraywriter_async_t::append_array: error: file is not open\n" );
+		return;
+	}
+#ifdef ARRAYWRITER_ASYNC
+	size_t pos = st->enqueuepos.load ( std::memory_order_relaxed );
+	arraywriter_state_t::cell_t *c;
+	bool waited=false;
+	while ( 1 ) {
+		c = &st->cells[pos & st->mask];
+		const size_t seq = c->sequence.load ( std::memory_order_acquire );
+		const long diff = ( long ) seq - ( long ) pos;
+		if ( diff==0 ) {
+			if ( st->enqueuepos.compare_exchange_weak ( pos, pos+1, std::memory_order_relaxed ) )
+				break;
+		} else {
+			if ( diff<0 ) {
+				// buffer is full, wait for the writer
+				waited=true;
+				std::this_thread::yield();
+			}
+			pos = st->enqueuepos.load ( std::memory_order_relaxed );
+		}
+	}
+	if ( c->al.array!=0 && c->al.n_rows==al.n_rows && c->al.n_columns==al.n_columns ) {
+		// re-use the storage of the element
+		std::copy ( al.array, al.array+al.n_rows*al.n_columns, c->al.array );
+		c->al.index = al.index;
+	} else
+		c->al = al;
+	c->sequence.store ( pos+1, std::memory_order_release );
+	st->nadded++;
+	if ( waited )
+		st->nwaits++;
+#else
+#ifdef DOOPENMP
+	#pragma omp critical (arraywriter)
+#endif
+	{
+		const double t0 = get_time_ms();
+		st->afile.append_array ( al );
+		st->nadded++;
+		st->nwritten++;
+		if ( t0-st->lastflush>st->flushinterval ) {
+			fflush ( st->afile.nfid );
+			st->lastflush=t0;
+		}
+		st->nbytes = st->afile.nbytes_encoded();
+		st->writetime += get_time_ms()-t0;
+	}
+#endif
+}
+
+void arraywriter_async_t::append_arrays ( const arraylist_t &arrays )
+{
+	for ( arraylist_t::const_iterator it = arrays.begin(); it != arrays.end(); ++it )
+		this->append_array ( *it );
+}
+
+void arraywriter_async_t::flush()
+{
+	arraywriter_state_t *st = this->state;
+	if ( ! st->afile.isopen() )
+		return;
+#ifdef ARRAYWRITER_ASYNC
+	const long target = st->nadded.load();
+	while ( st->nwritten.load() < target )
+		std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+	st->flushrequest=true;
+	while ( st->flushrequest.load() )
+		std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+#else
+	fflush ( st->afile.nfid );
+#endif
+}
+
+void arraywriter_async_t::close()
+{
+	arraywriter_state_t *st = this->state;
+#ifdef ARRAYWRITER_ASYNC
+	if ( st->worker.joinable() ) {
+		st->stop=true;
+		st->worker.join();
+	}
+#endif
+	if ( st->afile.isopen() ) {
+		// the remaining blocks of a block file are compressed and written when the file is closed
+		const double t0 = get_time_ms();
+		st->nbytes = st->afile.nbytes_encoded();
+		st->afile.finisharrayfile();
+#ifdef ARRAYWRITER_ASYNC
+		st->writetime_us += ( long long ) ( 1e6* ( get_time_ms()-t0 ) );
+#else
+		st->writetime += get_time_ms()-t0;
+#endif
+	}
+}
+
+long arraywriter_async_t::narrays_added() const
+{
+	return this->state->nadded;
+}
+
+long arraywriter_async_t::narrays_written() const
+{
+	return this->state->nwritten;
+}
+
+long long arraywriter_async_t::nbytes_written() const
+{
+	return this->state->nbytes;
+}
+
+long arraywriter_async_t::nwaits() const
+{
+	return this->state->nwaits;
+}
+
+double arraywriter_async_t::writetime() const
+{
+#ifdef ARRAYWRITER_ASYNC
+	return 1e-6*this->state->writetime_us.load();
+#else
+	return this->state->writetime;
+#endif
+}
+
+double arraywriter_async_t::throughput() const
+{
+	double dt = this->writetime();
+	if ( dt<=0 )
+		return 0;
+	return this->narrays_written() /dt;
+}
+
+std::string arraywriter_async_t::showstr() const
+{
+	return printfstring ( "arraywriter_async_t: %s: %ld arrays added, %ld written, %lld bytes, %ld waits, %.0f arrays/s", this->state->afile.filename.c_str(), this->narrays_added(), this->narrays_written(), this->nbytes_written(), this->nwaits(), this->throughput() );
+}
+
+#endif // FULLPACKAGE, related to arrayfile_t
+
+
+void  selectArrays ( const arraylist_t &al,   std::vector<int> &idx, arraylist_t &rl )
+{
+	for ( std::vector<int>::iterator it = idx.begin(); it<idx.end(); it++ ) {
+		rl.push_back ( al.at ( *it ) );
+	}
+}
+void  selectArrays ( const arraylist_t &al,   std::vector<long> &idx, arraylist_t &rl )
+{
+	for ( std::vector<long>::iterator it = idx.begin(); it<idx.end(); it++ ) {
+		if ( ( *it ) >=0 && ( ( *it ) < ( int ) al.size() ) )
+			rl.push_back ( al.at ( *it ) );
+		else {
+			myprintf ( "selectArrays: index %ld out of bounds!\n", *it );
+		}
+	}
+}
+
+arrayblock_t::arrayblock_t ( rowindex_t nrows, colindex_t ncols ) : n_rows ( nrows ), n_columns ( ncols )
+{
+}
+
+arrayblock_t::arrayblock_t ( const arraylist_t &arraylist ) : n_rows ( 0 ), n_columns ( 0 )
+{
+	if ( arraylist.size() >0 ) {
+		n_rows = arraylist[0].n_rows;
+		n_columns = arraylist[0].n_columns;
+	}
+	reserve ( arraylist.size() );
+	for ( size_t i=0; i<arraylist.size(); i++ )
+		push_back ( arraylist[i] );
+}
+
+void arrayblock_t::reserve ( long n )
+{
+	storage.reserve ( n*arraysize() );
+	indices.reserve ( n );
+	order.reserve ( n );
+}
+
+void arrayblock_t::push_back ( const array_link &al )
+{
+	if ( al.n_rows!=n_rows || al.n_columns!=n_columns ) {
+		myprintf ( "arrayblock_t::push_back: error: array of size %dx%d does not fit in block of size %dx%d\n", al.n_rows, al.n_columns, n_rows, n_columns );
+		return;
+	}
+	order.push_back ( indices.size() );
+	indices.push_back ( al.index );
+	storage.insert ( storage.end(), al.array, al.array+arraysize() );
+}
+
+void arrayblock_t::select ( const std::vector<long> &idx )
+{
+	std::vector<long> neworder ( idx.size() );
+	for ( size_t i=0; i<idx.size(); i++ ) {
+		if ( idx[i]<0 || idx[i]>=size() ) {
+			myprintf ( "arrayblock_t::select: error: index out of bounds: index %ld, size %ld\n", idx[i], size() );
+			return;
+		}
+		neworder[i] = order[idx[i]];
+	}
+	order.swap ( neworder );
+}
+
+/// helper class: compare arrays in an arrayblock_t by their storage position
+struct arrayblock_less_t {
+	const array_t *storage;
+	long arraysize;
+
+	bool operator() ( long a, long b ) const {
+		const array_t *pa = storage+a*arraysize;
+		const array_t *pb = storage+b*arraysize;
+		return std::lexicographical_compare ( pa, pa+arraysize, pb, pb+arraysize );
+	}
+};
+
+void arrayblock_t::sort()
+{
+	if ( storage.size() ==0 )
+		return;
+	arrayblock_less_t cmp;
+	cmp.storage = &storage[0];
+	cmp.arraysize = arraysize();
+	std::stable_sort ( order.begin(), order.end(), cmp );
+}
+
+void arrayblock_t::compact()
+{
+	const long n = size();
+	std::vector<array_t> newstorage ( n*arraysize() );
+	std::vector<int> newindices ( n );
+	for ( long i=0; i<n; i++ ) {
+		std::copy ( data ( i ), data ( i ) +arraysize(), newstorage.begin() +i*arraysize() );
+		newindices[i] = indices[order[i]];
+		order[i] = i;
+	}
+	storage.swap ( newstorage );
+	indices.swap ( newindices );
+}
+
+arraylist_t arrayblock_t::toArrayList() const
+{
+	arraylist_t lst;
+	for ( long i=0; i<size(); i++ ) {
+		lst.push_back ( array_link ( n_rows, n_columns, indices[order[i]], data ( i ) ) );
+	}
+	return lst;
+}
+
+packedarray_t::packedarray_t() : n_rows ( 0 ), n_columns ( 0 ), nw ( 0 ), index ( array_link::INDEX_DEFAULT )
+{
+}
+
+packedarray_t::packedarray_t ( const array_link &al ) : index ( al.index )
+{
+	this->init ( al.n_rows, al.n_columns );
+	for ( int c=0; c<n_columns; c++ ) {
+		const array_t *col = al.array+c*n_rows;
+		unsigned long long *w = &words[ ( size_t ) c*nw];
+		for ( int r=0; r<n_rows; r++ )
+			w[r/64] |= ( ( unsigned long long ) ( col[r] & 1 ) ) << ( r%64 );
+	}
+}
+
+packedarray_t::packedarray_t ( const unsigned char *bitstream, rowindex_t nrows, colindex_t ncols, int index_ ) : index ( index_ )
+{
+	this->setbitstream ( bitstream, nrows, ncols );
+}
+
+void packedarray_t::init ( rowindex_t nrows, colindex_t ncols )
+{
+	this->n_rows = nrows;
+	this->n_columns = ncols;
+	this->nw = ( nrows+63 ) /64;
+	this->words.assign ( ( size_t ) nw*ncols, 0 );
+}
+
+/// load a word of the bit stream, the stream is not necessarily aligned
+static inline unsigned long long loadstreamword ( const unsigned char *bitstream, size_t w )
+{
+	unsigned long long word;
+	memcpy ( &word, bitstream+w*sizeof ( word ), sizeof ( word ) );
+	return word;
+}
+
+void packedarray_t::setbitstream ( const unsigned char *bitstream, rowindex_t nrows, colindex_t ncols )
+{
+	this->n_rows = nrows;
+	this->n_columns = ncols;
+	this->nw = ( nrows+63 ) /64;
+	this->words.resize ( ( size_t ) nw*ncols );
+
+	// the stream contains the columns without padding, so each column is shifted into word alignment
+	const size_t nstream = ( ( size_t ) nrows*ncols+63 ) /64;
+	const int rest = nrows%64;
+	const unsigned long long lastmask = rest ? ( 1ULL << rest )-1 : ~0ULL;
+	for ( int c=0; c<ncols; c++ ) {
+		unsigned long long *dst = &words[ ( size_t ) c*nw];
+		const size_t offset = ( size_t ) c*nrows;
+		const size_t s = offset/64;
+		const int shift = offset%64;
+		if ( shift==0 ) {
+			for ( int w=0; w<nw; w++ )
+				dst[w] = loadstreamword ( bitstream, s+w );
+		} else {
+			unsigned long long lo = loadstreamword ( bitstream, s );
+			for ( int w=0; w<nw; w++ ) {
+				unsigned long long hi = ( s+w+1<nstream ) ? loadstreamword ( bitstream, s+w+1 ) : 0;
+				dst[w] = ( lo >> shift ) | ( hi << ( 64-shift ) );
+				lo=hi;
+			}
+		}
+		if ( nw>0 )
+			dst[nw-1] &= lastmask;
+	}
+}
+
+array_link packedarray_t::toArray() const
+{
+	array_link al ( n_rows, n_columns, index );
+	for ( int c=0; c<n_columns; c++ ) {
+		const unsigned long long *w = this->column ( c );
+		array_t *col = al.array+c*n_rows;
+		for ( int r=0; r<n_rows; r++ )
+			col[r] = ( w[r/64] >> ( r%64 ) ) & 1;
+	}
+	return al;
+}
+
+arraylist_t uniqueArrays ( const arraylist_t &arraylist, std::vector<int> *uniqueindices, int verbose )
+{
+	const long narrays = arraylist.size();
+	std::vector<unsigned long long> hashes ( narrays );
+
+#ifdef DOOPENMP
+	#pragma omp parallel for schedule(static)
+#endif
+	for ( long i=0; i<narrays; i++ )
+		hashes[i] = arraylist[i].hashvalue();
+
+	// arrays with equal hash values are compared element by element
+	std::multimap<unsigned long long, long> seen;
+	arraylist_t result;
+	if ( uniqueindices!=0 )
+		uniqueindices->clear();
+	for ( long i=0; i<narrays; i++ ) {
+		typedef std::multimap<unsigned long long, long>::const_iterator iterator_t;
+		std::pair<iterator_t, iterator_t> range = seen.equal_range ( hashes[i] );
+		bool found=false;
+		for ( iterator_t it=range.first; it!=range.second; ++it ) {
+			if ( arraylist[it->second]==arraylist[i] ) {
+				found=true;
+				break;
+			}
+		}
+		if ( found )
+			continue;
+		seen.insert ( std::pair<unsigned long long, long> ( hashes[i], i ) );
+		result.push_back ( arraylist[i] );
+		if ( uniqueindices!=0 )
+			uniqueindices->push_back ( i );
+	}
+
+	if ( verbose )
+		myprintf ( "uniqueArrays: %ld arrays, %ld unique\n", narrays, ( long ) result.size() );
+	return result;
 }
 
 arraylist_t  selectArrays ( const arraylist_t &al,   std::vector<int> &idx )
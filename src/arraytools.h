@@ -65,6 +65,7 @@ typedef unsigned __int32 uint32_t;
 #include <sstream>
 #include <fstream>
 #include <stdarg.h>
+#include <utility>
 
 #include <stdexcept>
 
@@ -74,6 +75,13 @@ namespace Eigen {
 typedef Eigen::Matrix<long double, Eigen::Dynamic, Eigen::Dynamic> MatrixXld;
 }
 
+/// move an object if the compiler supports rvalue references, otherwise make a copy
+#if __cplusplus >= 201103L
+#define OA_MOVE(x) std::move(x)
+#else
+#define OA_MOVE(x) (x)
+#endif
+
 /// default float matrix type used
 //typedef Eigen::MatrixXf MatrixFloat; typedef Eigen::ArrayXf ArrayFloat; typedef float eigenFloat;
 
@@ -188,6 +196,7 @@ typedef int vindex_t;	/* value index type */
 // forward declarations
 struct array_link;
 struct arraydata_t;
+class packedarray_t;
 
 
 /**
@@ -213,6 +222,8 @@ public:
 	jstruct_t ( const int N, const int K, const int jj = 4 );
 	jstruct_t ( const jstruct_t &js );
 	jstruct_t ( const array_link &al, int jj=4 );
+	/// calculate the J-characteristics of a two-level array with packed columns
+	jstruct_t ( const packedarray_t &pa, int jj=4 );
 	~jstruct_t();
 
 private:
@@ -222,10 +233,17 @@ private:
 	void calc ( const array_link &al );
 	/// calculate J-characteristics, special function for jj=4
 	void calcj4 ( const array_link &al );
+	/// calculate J-characteristics from packed columns
+	void calc ( const packedarray_t &pa );
 
 public:
 	jstruct_t &operator= ( const jstruct_t &rhs );	// assignment
 
+	/// calculate the J-characteristics of an array, reusing the allocated data if the size of the array is unchanged
+	void calculate ( const array_link &al );
+	/// calculate the J-characteristics of a two-level array with packed columns
+	void calculate ( const packedarray_t &pa );
+
 	std::vector<int> Fval ( int strength = 3 ) const;
 	std::vector<int> calculateF ( int strength = 3 ) const;
 
@@ -286,6 +304,9 @@ public:
 	arraydata_t ( const std::vector<int> s, rowindex_t N, colindex_t strength, colindex_t ncols );
 	arraydata_t ( const array_t *s_, rowindex_t N, colindex_t strength, colindex_t ncols );
 	arraydata_t ( const arraydata_t &adp ); /// copy constructor
+#if __cplusplus >= 201103L
+	arraydata_t ( arraydata_t &&adp ) noexcept; /// move constructor
+#endif
 
 	arraydata_t ( const arraydata_t *adp, colindex_t newncols ); /// copy constructor
 
@@ -309,17 +330,11 @@ public:
 	void writeConfigFile ( const char *filename ) const;
 
 	/// @brief assignment operator
-	inline arraydata_t& operator= ( const arraydata_t &ad2 ) {
-		this->N = ad2.N;
-		this->strength=ad2.strength;
-		this->ncols=ad2.ncols;
-		this->order=ad2.order;
-		if ( s!=0 )
-			delete [] s;
-		this->s = new array_t[this->ncols];
-		std::copy ( ad2.s, ad2.s+this->ncols, s );
-		return *this;
-	}
+	arraydata_t& operator= ( const arraydata_t &ad2 );
+#if __cplusplus >= 201103L
+	/// @brief move assignment operator
+	arraydata_t& operator= ( arraydata_t &&ad2 ) noexcept;
+#endif
 
 	/// @brief Comparison operator
 	inline int operator== ( const arraydata_t &ad2 ) {
@@ -613,6 +628,10 @@ struct array_link {
 	array_link ( rowindex_t nrows, colindex_t ncols, int index, carray_t *data );
 	~array_link();
 	array_link ( const array_link & );
+#if __cplusplus >= 201103L
+	/// move constructor, the data of the argument is taken over
+	array_link ( array_link &&rhs ) noexcept;
+#endif
 	array_link ( Eigen::MatrixXd &m );
 
 	array_link clone() const;
@@ -710,6 +729,9 @@ public:
 	/* Interal function (public, but not in documentation */
 
 	array_link &operator= ( const array_link &rhs );	// assignment
+#if __cplusplus >= 201103L
+	array_link &operator= ( array_link &&rhs ) noexcept;	// move assignment
+#endif
 	array_link &deepcopy ( const array_link &rhs );	// assignment
 	array_link &shallowcopy ( const array_link &rhs );	// assignment
 	int operator== ( const array_link &rhs ) const;
@@ -761,6 +783,9 @@ public:
 
 	/// return md5 sum of array representation (as represented with 32bit int datatype in memory)
 	std::string md5() const;
+
+	/// return 64-bit hash of the array dimensions and data
+	unsigned long long hashvalue() const;
 	
 	bool firstDiff ( const array_link &A, int &r, int &c, int verbose=1 ) {
 		r=0;
@@ -982,6 +1007,8 @@ inline  array_link & array_link::shallowcopy ( const array_link& rhs )
 
 inline  array_link & array_link::deepcopy ( const array_link& rhs )
 {
+	if ( this==&rhs )
+		return *this;
 	this->n_rows = rhs.n_rows;
 	this->n_columns = rhs.n_columns;
 	this->index = rhs.index;
@@ -997,6 +1024,36 @@ inline  array_link & array_link::deepcopy ( const array_link& rhs )
 	return *this;
 }
 
+#if __cplusplus >= 201103L
+inline array_link::array_link ( array_link &&rhs ) noexcept : n_rows ( rhs.n_rows ), n_columns ( rhs.n_columns ), index ( rhs.index ), array ( rhs.array )
+{
+	rhs.array=0;
+	rhs.n_rows=-1;
+	rhs.n_columns=0;
+}
+
+/**
+ * @brief Move assignment operator
+ */
+inline  array_link & array_link::operator= ( array_link&& rhs ) noexcept
+{
+	if ( this==&rhs )
+		return *this;
+#ifdef CLEAN_ARRAY_LINK
+	if ( this->array!=0 )
+		destroy_array ( this->array );
+#endif
+	this->n_rows = rhs.n_rows;
+	this->n_columns = rhs.n_columns;
+	this->index = rhs.index;
+	this->array = rhs.array;
+	rhs.array=0;
+	rhs.n_rows=-1;
+	rhs.n_columns=0;
+	return *this;
+}
+#endif
+
 /**
  * @brief Comparision operator for the array link
  */
@@ -1066,6 +1123,195 @@ inline int array_link::operator!= ( const array_link& b ) const
 	return ( ! std::equal ( array, array + n_rows*n_columns, b.array ) );
 }
 
+/** @brief Non-owning read-only view of array data
+ *
+ * The data is owned by another object, for example an arrayblock_t, and is not freed when the view is destroyed. The
+ * view converts to a const array_link, so it can be passed to every function that takes a const array_link &, but it
+ * cannot be modified or assigned to through the array_link interface. Copying the view into an array_link makes a
+ * deep copy. The view is only valid as long as the data it refers to.
+ */
+class arrayview_t
+{
+public:
+	arrayview_t ( const array_t *data, rowindex_t nrows, colindex_t ncols, int index = array_link::INDEX_DEFAULT ) {
+		view.n_rows = nrows;
+		view.n_columns = ncols;
+		view.index = index;
+		view.array = const_cast<array_t *> ( data );
+	}
+	arrayview_t ( const arrayview_t &rhs ) {
+		view.shallowcopy ( rhs.view );
+	}
+	~arrayview_t() {
+		// the data is not owned by the view
+		view.array = 0;
+	}
+
+	/// return the array
+	const array_link &array() const {
+		return view;
+	}
+	operator const array_link & () const {
+		return view;
+	}
+
+private:
+	array_link view;
+
+	arrayview_t &operator= ( const arrayview_t & );
+};
+
+/// return pointer to array data in a buffer of 32-bit integers, the buffer can be used directly since array_t is int
+inline const array_t *int32arraydata ( const array_t *data, size_t, std::vector<array_t> & )
+{
+	return data;
+}
+
+template <class IntType>
+/// return pointer to array data in a buffer of 32-bit integers, the values are converted to array_t
+const array_t *int32arraydata ( const IntType *data, size_t n, std::vector<array_t> &converted )
+{
+	converted.assign ( data, data+n );
+	return converted.empty() ? 0 : &converted[0];
+}
+
+/** @brief Array stored in a column-major buffer of 32-bit integers, for example an R integer matrix
+ *
+ * If array_t is a 32-bit integer the array is a view of the buffer and no data is copied. Otherwise the values are
+ * converted once into a buffer owned by this object. The array is valid as long as this object and the buffer exist.
+ */
+class int32arrayview_t
+{
+public:
+	int32arrayview_t ( const int *data, rowindex_t nrows, colindex_t ncols, int index = array_link::INDEX_DEFAULT ) : view ( int32arraydata ( data, ( size_t ) nrows*ncols, converted ), nrows, ncols, index ) {
+	}
+
+	/// return the array
+	const array_link &array() const {
+		return view.array();
+	}
+	/// return true if the array uses the memory of the buffer
+	bool iszerocopy() const {
+		return converted.empty() && view.array().n_rows*view.array().n_columns>0;
+	}
+
+private:
+	std::vector<array_t> converted;
+	arrayview_t view;
+
+	int32arrayview_t ( const int32arrayview_t & );
+	int32arrayview_t &operator= ( const int32arrayview_t & );
+};
+
+/** @brief Container for arrays of the same size
+ *
+ * The arrays are stored contiguously in a single buffer. The order of the arrays is given by an index vector, so
+ * selection and sorting only permute the indices and do not copy array data. The arrays can be accessed as
+ * non-owning read-only views.
+ *
+ * The views point into the buffer: push_back, reserve and compact invalidate all views, as does destruction of the
+ * block. Since select and sort only permute the indices, a view obtained before these operations remains valid and
+ * refers to the same array, which may then be at a different position or no longer selected.
+ */
+class arrayblock_t
+{
+public:
+	/// number of rows of the arrays
+	rowindex_t n_rows;
+	/// number of columns of the arrays
+	colindex_t n_columns;
+
+	arrayblock_t ( rowindex_t nrows, colindex_t ncols );
+	/// create block from a list of arrays, all arrays should have the same size
+	arrayblock_t ( const arraylist_t &arraylist );
+
+	/// number of arrays in the block
+	long size() const {
+		return order.size();
+	}
+	/// reserve space for the specified number of arrays
+	void reserve ( long n );
+	/// add an array to the block
+	void push_back ( const array_link &al );
+
+	/// return a read-only view of the array at the specified position
+	arrayview_t operator[] ( long i ) const {
+		return arrayview_t ( &storage[order[i]*arraysize()], n_rows, n_columns, indices[order[i]] );
+	}
+	/// return a pointer to the data of the array at the specified position
+	const array_t *data ( long i ) const {
+		return &storage[order[i]*arraysize()];
+	}
+
+	/// keep only the arrays at the specified positions, in the specified order
+	void select ( const std::vector<long> &idx );
+	/// sort the arrays in the same order as the comparison operator of array_link
+	void sort();
+	/// store the arrays in the current order and release the storage of arrays that are no longer selected
+	void compact();
+
+	/// convert to a list of arrays
+	arraylist_t toArrayList() const;
+
+private:
+	std::vector<array_t> storage;
+	std::vector<int> indices;
+	std::vector<long> order;
+
+	long arraysize() const {
+		return ( long ) n_rows*n_columns;
+	}
+};
+
+/** @brief Two-level array with bit packed columns
+ *
+ * Column c is stored in nw consecutive 64-bit words, the value in row r is bit r%64 of word r/64. Unused bits in the
+ * last word of a column are zero. The packed kernels for the J-characteristics, the GWLP and the information matrix
+ * work directly on the words, so a two-level design read from a 1-bit array file is never expanded to array_t values.
+ */
+class packedarray_t
+{
+public:
+	/// number of rows
+	rowindex_t n_rows;
+	/// number of columns
+	colindex_t n_columns;
+	/// number of 64-bit words per column
+	int nw;
+	/// index of the array
+	int index;
+	/// packed columns
+	std::vector<unsigned long long> words;
+
+	packedarray_t();
+	/// pack a two-level array, only the lowest bit of each value is used
+	explicit packedarray_t ( const array_link &al );
+	/// create from the bit stream of a 1-bit array in a binary array file
+	packedarray_t ( const unsigned char *bitstream, rowindex_t nrows, colindex_t ncols, int index_ = array_link::INDEX_DEFAULT );
+
+	/// set the columns from the bit stream of a 1-bit array in a binary array file, the data does not need to be aligned
+	void setbitstream ( const unsigned char *bitstream, rowindex_t nrows, colindex_t ncols );
+
+	/// return pointer to the words of the specified column
+	const unsigned long long *column ( int c ) const {
+		return &words[ ( size_t ) c*nw];
+	}
+	/// return value at the specified position
+	int at ( rowindex_t r, colindex_t c ) const {
+		return ( words[ ( size_t ) c*nw+r/64] >> ( r%64 ) ) & 1;
+	}
+
+	/// convert to an array_link
+	array_link toArray() const;
+
+	std::string showstr() const {
+		return printfstring ( "packedarray_t: %d, %d, index %d", n_rows, n_columns, index );
+	}
+
+private:
+	void init ( rowindex_t nrows, colindex_t ncols );
+};
+
 /// Compare 2 arrays and return position of first difference
 int array_diff ( carray_p A, carray_p B, const rowindex_t r, const colindex_t c, rowindex_t &rpos, colindex_t &cpos );
 
@@ -1083,6 +1329,20 @@ int jvalue ( const array_link &ar,const int J, const int *pp );
 /// Analyse a list of arrays
 std::vector<jstruct_t> analyseArrays ( const arraylist_t &arraylist,  const int verbose, const int jj = 4 );
 
+/** Analyse a list of arrays in parallel
+ *
+ * The F-values of the arrays are returned as the rows of an integer matrix. If the aberration argument is non-zero
+ * the aberration values are stored in it. The J-characteristics are only stored if the jvalues argument is non-zero,
+ * for jj=4 the F-values and aberration are then calculated without storing any J-values.
+ */
+Eigen::MatrixXi analyseArraysF ( const arraylist_t &arraylist, int jj = 4, std::vector<double> *aberration = 0, std::vector<std::vector<int> > *jvalues = 0, int verbose = 0 );
+
+/** Calculate the F-values of an array
+ *
+ * For jj=4 the F-values are accumulated while the J-characteristics are generated, so the C(k,4) J-values are never stored.
+ */
+std::vector<int> calculateF ( const array_link &al, int jj = 4, int strength = 3 );
+
 /** \brief Contains a transformation of an array
  *
  * Contains an array transformation. The transformation consists of column, row and
@@ -1243,9 +1503,16 @@ namespace arrayfile
 {
 
 /// format mode
-enum arrayfilemode_t {ATEXT, ALATEX, ABINARY, ABINARY_DIFF, ABINARY_DIFFZERO, AERROR};
+enum arrayfilemode_t {ATEXT, ALATEX, ABINARY, ABINARY_DIFF, ABINARY_DIFFZERO, AERROR, ABINARY_BLOCK};
 enum afilerw_t {READ, WRITE, READWRITE};
 
+/// location of a block of arrays in a file in ABINARY_BLOCK format
+struct arrayfile_blockinfo_t {
+	long long offset;	/// position of the block in the file
+	int csize;	/// size of the block in the file
+	int usize;	/// size of the block after decompression
+};
+
 /** @brief Structure for reading or writing a file with arrays
  *
  * The format of array files is described in the file FORMAT.txt
@@ -1295,10 +1562,23 @@ public:
 	int seek ( int pos );
 	/// read array and return index
 	int read_array ( array_link &a );
+	/** read array into packed format and return index
+	 *
+	 * For 1-bit files in ABINARY or ABINARY_BLOCK format the data of the file is copied to the packed columns
+	 * directly. For other formats the array is read and then packed.
+	 */
+	int read_array ( packedarray_t &pa );
 
 	/// return true if the file has binary format
 	bool isbinary() const;
 
+	/** return the number of bytes of the encoded arrays written, including the header
+	 *
+	 * For the ABINARY_BLOCK format the size of the arrays before compression is returned, since the blocks are
+	 * only compressed and written when they are complete.
+	 */
+	long long nbytes_encoded() const;
+
 	/// append arrays to the file
 	int append_arrays ( const arraylist_t &arrays, int startidx );
 
@@ -1335,6 +1615,9 @@ public:
 			case ABINARY_DIFFZERO:
 				modestr="binary_diffzero";
 				break;
+			case ABINARY_BLOCK:
+				modestr="binary_block";
+				break;
 			case AERROR:
 				modestr="invalid";
 				break;
@@ -1363,7 +1646,7 @@ public:
 	}
 	/// return true of the file format has random access mode
 	bool hasrandomaccess() const {
-		return ( this->mode==ABINARY );
+		return ( this->mode==ABINARY || this->mode==ABINARY_BLOCK );
 	}
 
 	static const int NARRAYS_MAX = 2 * 1000 * 1000 * 1000;	/* maximum number of arrays in structure */
@@ -1383,6 +1666,19 @@ public:	// hack
 private:
 	array_link diffarray;
 
+	/// number of arrays in a block for the ABINARY_BLOCK format
+	int blocksize;
+	/// uncompressed data of the current block
+	std::vector<unsigned char> blockdata;
+	/// index of the block in blockdata when reading, -1 if no block has been loaded
+	long currentblock;
+	/// complete blocks that have not been written yet
+	std::vector<std::vector<unsigned char> > pendingblocks;
+	/// location of the blocks in the file
+	std::vector<arrayfile_blockinfo_t> blockindex;
+	/// buffer for the bit stream of a 1-bit array read in packed format
+	std::vector<unsigned char> packedbuffer;
+
 	/// return header size for binary format array
 	int headersize() const {
 		return 8*sizeof ( int32_t );
@@ -1441,12 +1737,24 @@ public:
 		this->verbose = v;
 	}
 
+	/// set the number of arrays per block for the ABINARY_BLOCK format, only valid before arrays are written
+	void setBlocksize ( int n );
+
+	/// read all remaining arrays of a file in ABINARY_BLOCK format and append them to a list. the blocks are decompressed in parallel
+	long read_arrays_block ( arraylist_t &arrays );
+
 private:
 	int read_array_binary_zero ( array_link &a );
 	void write_array_binary ( carray_t *array, const int nrows, const int ncols );
 	void write_array_binary ( const array_link &A );
 	void write_array_binary_diff ( const array_link &A );
 	void write_array_binary_diffzero ( const array_link &A );
+	int read_array_block ( array_t *array );
+	const unsigned char *next_block_record ( int32_t &index );
+	int loadblock ( long b );
+	int readblockindex();
+	void writependingblocks();
+	void writeblockindex();
 	
 public:
 	int getnbits() {
@@ -1465,7 +1773,10 @@ public:
 				if ( format=="Z" || format=="DIFFZERO" )  {
 					mode = arrayfile::ABINARY_DIFFZERO;
 				} else {
-					mode = arrayfile::ATEXT;
+					if ( format=="K" || format=="BLOCK" )
+						mode = arrayfile::ABINARY_BLOCK;
+					else
+						mode = arrayfile::ATEXT;
 				}
 			}
 		}
@@ -1513,6 +1824,217 @@ protected:
 
 };
 
+/** @brief Random access reader for array files in binary format
+ *
+ * The file is mapped into memory and arrays are accessed by index, without seeking or reading the file
+ * sequentially. The raw data of an array can be accessed without making a copy. All access methods are const and
+ * can be called from multiple threads at the same time.
+ *
+ * Only the ABINARY format is supported (8-bit, 32-bit and 1-bit packed data). For compressed files and on systems
+ * without mmap the file is read into a memory buffer instead.
+ */
+class arrayfile_mmap_t
+{
+public:
+	std::string filename;
+	int nrows;
+	int ncols;
+	/// number of bits used for a single value
+	int nbits;
+	/// number of arrays in the file
+	int narrays;
+
+	/// open an existing array file
+	arrayfile_mmap_t ( const std::string fname, int verbose = 1 );
+	~arrayfile_mmap_t();
+
+	/// return true if the file is open
+	bool isopen() const {
+		return this->data!=0;
+	}
+
+	/// return pointer to the data of the specified array in the file, the data is not copied
+	const unsigned char *rawdata ( int i ) const {
+		return this->data + this->headersize() + this->recordsize* ( size_t ) i + sizeof ( int32_t );
+	}
+	/// return number of bytes of the data of a single array
+	size_t rawsize() const {
+		return this->recordsize - sizeof ( int32_t );
+	}
+
+	/// return the index stored with the specified array
+	int arrayindex ( int i ) const;
+
+	/// decode the specified array into a buffer of size nrows*ncols, return the index of the array or -1 on error
+	int read_array ( int i, array_t *array ) const;
+
+	/// return the specified array
+	array_link getarray ( int i ) const;
+	/// read the specified array into packed format, return the index of the array or -1 on error. for 1-bit files the data is not decoded
+	int read_array ( int i, packedarray_t &pa ) const;
+
+	/// decode a selection of arrays and append them to a list, the arrays are decoded in parallel
+	void selectArrays ( const std::vector<int> &idx, arraylist_t &rl, int verbose=0 ) const;
+
+	std::string showstr() const {
+		if ( ! this->isopen() )
+			return "file " + filename + ": invalid file";
+		return printfstring ( "file %s: %d rows, %d columns, %d arrays, nbits %d, mapped %d", filename.c_str(), nrows, ncols, narrays, nbits, mapped );
+	}
+
+private:
+	const unsigned char *data;
+	size_t datasize;
+	size_t recordsize;
+	/// true if the data is memory mapped, otherwise it is stored in buffer
+	int mapped;
+	std::vector<unsigned char> buffer;
+
+	int headersize() const {
+		return 8*sizeof ( int32_t );
+	}
+	void closefile();
+	int loadbuffer ( const std::string &fname );
+
+	arrayfile_mmap_t ( const arrayfile_mmap_t & );
+	arrayfile_mmap_t &operator= ( const arrayfile_mmap_t & );
+};
+
+/// access point into a compressed array file, the state of the decompressor at the start of a deflate block
+struct arrayfile_accesspoint_t {
+	/// offset in the uncompressed data
+	int64_t uoffset;
+	/// offset in the compressed file
+	int64_t coffset;
+	/// number of bits of the byte before coffset that belong to the block
+	int bits;
+	/// the last 32 KB of uncompressed data before the access point
+	std::vector<unsigned char> window;
+};
+
+/** @brief Index with the positions of the arrays in a text or compressed array file
+ *
+ * Text files and compressed files can only be read sequentially. The index is created in a single pass over the file
+ * and contains the offset of every array in the uncompressed data. For compressed files the index also contains
+ * access points into the compressed data (as in zran.c from the zlib distribution), so decompression can start at
+ * most 1 MB before an array.
+ *
+ * The index is stored next to the array file with the extension .idx and is created again if the size or the
+ * modification time of the array file changes. Both text files and compressed binary files in ABINARY format are
+ * supported.
+ */
+class arrayfile_index_t
+{
+public:
+	std::string filename;
+	int nrows;
+	int ncols;
+	/// number of bits used for a single value, 0 for text files
+	int nbits;
+	/// number of arrays in the file, -1 if the index is invalid
+	int narrays;
+
+	/// load the index of an array file, the index is created if no valid index file exists
+	arrayfile_index_t ( const std::string fname, int verbose = 1 );
+
+	/// return true if the index can be used
+	bool isvalid() const {
+		return this->narrays>=0;
+	}
+
+	/// return the name of the index file of an array file
+	static std::string indexfilename ( const std::string fname ) {
+		return fname + ".idx";
+	}
+
+	/// return the specified array
+	array_link getarray ( int i ) const;
+
+	/** read a selection of arrays and append them to a list
+	 *
+	 * The indices do not need to be sorted and can contain duplicates. The arrays are read in order of their position in
+	 * the file and large selections are read in parallel.
+	 */
+	void selectArrays ( const std::vector<int> &idx, arraylist_t &rl, int verbose=0 ) const;
+
+	std::string showstr() const {
+		if ( ! this->isvalid() )
+			return "index of " + filename + ": invalid index";
+		return printfstring ( "index of %s: %d rows, %d columns, %d arrays, nbits %d, %d access points", filename.c_str(), nrows, ncols, narrays, nbits, ( int ) accesspoints.size() );
+	}
+
+private:
+	int iscompressed;
+	int64_t filesize;
+	int64_t filetime;
+	/// offsets of the arrays in the uncompressed data, the last element is the end of the data of the last array
+	std::vector<int64_t> offsets;
+	std::vector<arrayfile_accesspoint_t> accesspoints;
+
+	int build ( int verbose );
+	int load ( const std::string &indexfile );
+	int save ( const std::string &indexfile ) const;
+	void readarrays ( const std::vector<int> &idx, const std::vector<long> &order, long i0, long i1, arraylist_t &rl, size_t start ) const;
+
+	friend class arrayfile_indexreader_t;
+};
+
+struct arraywriter_state_t;
+
+/** @brief Asynchronous writer for array files
+ *
+ * Arrays are added to a bounded ring buffer and written to an arrayfile_t by a background thread. The arrays are
+ * written in batches and, if arrays have been written since the last flush, the file is flushed at a fixed interval,
+ * also when no new arrays arrive. Arrays can be added from multiple threads at the
+ * same time, for example from the restarts of an optimization. If the buffer is full, the threads adding arrays wait
+ * until the writer has made room.
+ *
+ * Without C++11 support the arrays are written directly when they are added, and the file is only flushed when an
+ * array is added or the file is closed.
+ */
+class arraywriter_async_t
+{
+public:
+	/// open a new array file for writing
+	arraywriter_async_t ( const std::string fname, int nrows, int ncols, arrayfilemode_t mode = ABINARY, int nbits = 8, int capacity = 4096, double flushinterval = 1.0 );
+	/// write all remaining arrays and close the file
+	~arraywriter_async_t();
+
+	/// return true if the file is open
+	bool isopen() const;
+
+	/// add an array to the file
+	void append_array ( const array_link &al );
+	/// add a list of arrays to the file
+	void append_arrays ( const arraylist_t &arrays );
+
+	/// wait until all arrays added have been written and flush the file
+	void flush();
+	/// write all remaining arrays and close the file
+	void close();
+
+	/// number of arrays added
+	long narrays_added() const;
+	/// number of arrays written to the file
+	long narrays_written() const;
+	/// number of bytes of the encoded arrays written, for ABINARY_BLOCK files the size before compression
+	long long nbytes_written() const;
+	/// number of times an array could not be added because the buffer was full
+	long nwaits() const;
+	/// time spent by the writer on encoding and writing arrays (seconds)
+	double writetime() const;
+	/// number of arrays written per second of write time
+	double throughput() const;
+
+	std::string showstr() const;
+
+private:
+	arraywriter_state_t *state;
+
+	arraywriter_async_t ( const arraywriter_async_t & );
+	arraywriter_async_t &operator= ( const arraywriter_async_t & );
+};
+
 }
 
 using namespace arrayfile;
@@ -1544,9 +2066,54 @@ int writearrayfile ( const char *fname, const array_link &al, arrayfile::arrayfi
 /// append a single array to an array file. creates a new file if no file exists
 int appendarrayfile ( const char *fname, const array_link al );
 
-/// Make a selection of arrays from binary array file, append to list
+/** Make a selection of arrays from an array file, append to list
+ *
+ * The indices do not need to be sorted. For text files and compressed files the arrays are located with an index
+ * file, see arrayfile_index_t.
+ */
 void selectArrays ( const std::string filename,  std::vector<int> &idx, arraylist_t &fl, int verbose=0 );
 
+/** @brief Property calculation and selection for filterArrayFile
+ *
+ * The methods are called from multiple threads at the same time.
+ */
+class arraystream_filter_t
+{
+public:
+	virtual ~arraystream_filter_t() {}
+	/// calculate properties of an array
+	virtual std::vector<double> properties ( const array_link &al ) const = 0;
+	/// return true if the array with the specified properties should be kept
+	virtual bool keep ( const array_link &al, const std::vector<double> &properties ) const = 0;
+};
+
+/// result of filterArrayFile
+struct arraystream_result_t {
+	long nread;	/// number of arrays read
+	long nkept;	/// number of arrays that passed the filter
+};
+
+/** @brief Filter the arrays in a file and write the selected arrays to a new file
+ *
+ * The input file is processed in chunks, so the memory use does not depend on the size of the file. For each
+ * chunk the properties of the arrays are calculated in parallel. The selected arrays are written by an
+ * arraywriter_async_t, which writes while the next chunk is processed. If the writer cannot keep up, the processing
+ * waits for it. The input is read by the calling thread between the chunks, so reading is not overlapped with the
+ * calculation of the properties.
+ *
+ * For binary input files the number of bits of the output file is taken from the input file. For text input files
+ * it is determined from the first chunk, with a minimum of 8 bits. If a later array needs more bits, an error is
+ * reported and the filtering stops.
+ *
+ * @param infile Input array file
+ * @param outfile Output array file. If empty, the arrays are only counted
+ * @param filter Calculates the properties and selects the arrays
+ * @param mode File mode of the output file
+ * @param chunksize Number of arrays processed at the same time
+ * @param verbose Verbosity level
+ */
+arraystream_result_t filterArrayFile ( const std::string infile, const std::string outfile, const arraystream_filter_t &filter, arrayfile::arrayfilemode_t mode = arrayfile::ABINARY, int chunksize = 4096, int verbose = 0 );
+
 /// Select a single array from a file
 array_link selectArrays ( std::string filename, int ii );
 
@@ -1582,6 +2149,17 @@ arraylist_t  selectArrays ( const arraylist_t &al,   std::vector<long> &idx );
 void selectArrays ( const arraylist_t &al,  std::vector<int> &idx, arraylist_t &fl );
 void selectArrays ( const arraylist_t &al,  std::vector<long> &idx, arraylist_t &fl );
 
+/** @brief Return the unique arrays in a list
+ *
+ * The arrays are compared by their 64-bit hash value and arrays with equal hash values are compared element by element.
+ * The order of the first occurrences is kept.
+ *
+ * @param arraylist List of arrays
+ * @param uniqueindices If not zero, the indices of the unique arrays are stored here
+ * @param verbose Verbosity level
+ */
+arraylist_t uniqueArrays ( const arraylist_t &arraylist, std::vector<int> *uniqueindices = 0, int verbose = 0 );
+
 /// Make a selection of arrays, keep
 template <class Container, class IntType>
 void keepElements ( Container &al,  std::vector<IntType> &idx )
@@ -1795,6 +2373,9 @@ MatrixFloat array2eigenX1 ( const array_link &al, int intercept=1 );
 /// convert 2-level array to second order model matrix (intercept, X1, X2)
 MatrixFloat array2eigenModelMatrix ( const array_link &al );
 
+/// convert 2-level array to second order model matrix (intercept, X1, X2) with integer entries
+Eigen::MatrixXi array2eigenModelMatrixInt ( const array_link &al );
+
 
 MatrixFloat array2eigenME ( const array_link &al, int verbose = 1 );
 
@@ -1736,6 +1736,30 @@ inline unsigned int ipow ( unsigned int x, unsigned int p )
 	}
 }
 
+/// number of bits set in a 64-bit word
+inline int popcount64 ( unsigned long long x )
+{
+#ifdef __GNUC__
+	return __builtin_popcountll ( x );
+#else
+	x = x - ( ( x >> 1 ) & 0x5555555555555555ULL );
+	x = ( x & 0x3333333333333333ULL ) + ( ( x >> 2 ) & 0x3333333333333333ULL );
+	x = ( x + ( x >> 4 ) ) & 0x0f0f0f0f0f0f0f0fULL;
+	return ( int ) ( ( x * 0x0101010101010101ULL ) >> 56 );
+#endif
+}
+
+/// finalization step of the 64-bit MurmurHash3 hash
+inline unsigned long long fmix64 ( unsigned long long h )
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
 /// -1 to the power n (integer)
 inline int powmo ( int n )
 {
@@ -231,6 +231,60 @@ inline int freq_position(rowindex_t N, rowindex_t activerow, colindex_t ncols, c
 	return freq_pos;
 }
 
+strength_freqtable_t::strength_freqtable_t ( const arraydata_t &ad, int strength ) : strength_check_t ( strength ), N ( ad.N ), ncols ( ad.ncols ), col_index ( 0 ), nbad ( 0 ), sqdev ( 0 )
+{
+	set_colcombs ( ad );
+	indices = set_indices ( colcombs, ad.s, strength, ncolcombs );
+	freqtable = new_strength_freq_table ( ncolcombs, nvalues, freqtablesize );
+	col_index = create_reverse_colcombs ( colcombs, ncols, strength );
+}
+
+strength_freqtable_t::~strength_freqtable_t()
+{
+	if ( col_index!=0 ) {
+		for ( int c=0; c<ncols; c++ )
+			free ( col_index[c].index );
+		free ( col_index );
+	}
+}
+
+void strength_freqtable_t::init_frequencies ( const array_link &al )
+{
+	std::fill ( freqtable[0], freqtable[0]+freqtablesize, 0 );
+	for ( int i=0; i<ncolcombs; i++ ) {
+		for ( rowindex_t r=0; r<N; r++ )
+			freqtable[i][freq_position ( N, r, strength, colcombs[i], indices[i], al.array )]++;
+	}
+
+	nbad=0;
+	sqdev=0;
+	for ( int i=0; i<ncolcombs; i++ ) {
+		for ( int j=0; j<nvalues[i]; j++ ) {
+			const long d = freqtable[i][j]-lambda[i];
+			nbad += ( d!=0 );
+			sqdev += d*d;
+		}
+	}
+}
+
+void strength_freqtable_t::update ( const array_link &al, rowindex_t r, colindex_t c, array_t value )
+{
+	const array_t old = al.array[r+N*c];
+	if ( old==value )
+		return;
+
+	const rev_index &ri = col_index[c];
+	for ( int x=0; x<ri.nr_elements; x++ ) {
+		const int i = ri.index[x];
+		const int pos = freq_position ( N, r, strength, colcombs[i], indices[i], al.array );
+		int j=0;
+		while ( colcombs[i][j]!=c )
+			j++;
+		addcount ( i, pos, -1 );
+		addcount ( i, pos+indices[i][j]* ( value-old ), 1 );
+	}
+}
+
 /* NOTE:
  *
  * The size of the freqtable is pretty larg compared to the number of nonzero elements
@@ -454,99 +508,295 @@ bool valid_element(const extend_data_t *es, const extendpos *p, carray_t *array)
 
 #endif
 
+/// maximum number of value combinations for which the frequency counters are allocated on the stack
+static const int STRENGTH_STACK_COUNTERS = 512;
+
+/// read a flag that is shared between OpenMP threads
+static inline int readsharedflag ( const int &flag )
+{
+	int value;
+#ifdef DOOPENMP
+	#pragma omp atomic read
+#endif
+	value = flag;
+	return value;
+}
+
+/// set a flag that is shared between OpenMP threads
+static inline void setsharedflag ( int &flag, int value )
+{
+#ifdef DOOPENMP
+	#pragma omp atomic write
+#endif
+	flag = value;
+}
+
+/**
+ * @brief Check whether all t-tuples of values occur equally often
+ *
+ * The counting stops as soon as a t-tuple occurs more than N/nvalues times.
+ *
+ * @param valindex Value indices of the rows
+ * @param N Number of rows
+ * @param nvalues Number of possible t-tuples
+ * @return True if all t-tuples occur equally often
+ */
+static bool check_valindex ( const int *valindex, const int N, const int nvalues )
+{
+	if ( N % nvalues != 0 )
+		return false;
+	const int lambda = N/nvalues;
+
+	if ( lambda==1 ) {
+		// every t-tuple occurs exactly once: we only need a bitset
+		const int nw = ( nvalues+63 ) /64;
+		unsigned long long stackseen[STRENGTH_STACK_COUNTERS/8];
+		std::vector<unsigned long long> heapseen;
+		unsigned long long *seen = stackseen;
+		if ( nw>STRENGTH_STACK_COUNTERS/8 ) {
+			heapseen.resize ( nw );
+			seen = &heapseen[0];
+		}
+		std::fill ( seen, seen+nw, 0ULL );
+		for ( int r=0; r<N; r++ ) {
+			const int v = valindex[r];
+			const unsigned long long bit = 1ULL << ( v%64 );
+			if ( seen[v/64] & bit )
+				return false;
+			seen[v/64] |= bit;
+		}
+		return true;
+	}
+
+	int stackcounts[STRENGTH_STACK_COUNTERS];
+	std::vector<int> heapcounts;
+	int *counts = stackcounts;
+	if ( nvalues>STRENGTH_STACK_COUNTERS ) {
+		heapcounts.resize ( nvalues );
+		counts = &heapcounts[0];
+	}
+	std::fill ( counts, counts+nvalues, 0 );
+
+	for ( int r=0; r<N; r++ ) {
+		if ( ++counts[valindex[r]]>lambda )
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Check whether all t-tuples of values in a column combination occur equally often
+ *
+ * The value indices of the rows are calculated column by column, so the inner loops run over contiguous data.
+ *
+ * @param al Array to check
+ * @param s Factor levels
+ * @param colcomb Columns in the combination
+ * @param strength Number of columns in the combination
+ * @param valindex Buffer of size N for the value indices
+ * @return True if the combination is balanced
+ */
+static bool check_colcomb ( const array_link &al, const array_t *s, const colindex_t *colcomb, int strength, int *valindex )
+{
+	const int N = al.n_rows;
+
+	int nvalues=1;
+	for ( int t=0; t<strength; t++ )
+		nvalues *= s[colcomb[t]];
+	if ( N % nvalues != 0 )
+		return false;
+
+	std::fill ( valindex, valindex+N, 0 );
+	for ( int t=0; t<strength; t++ ) {
+		const int st = s[colcomb[t]];
+		const array_t *col = al.array+N*colcomb[t];
+		for ( int r=0; r<N; r++ )
+			valindex[r] = valindex[r]*st+col[r];
+	}
+
+	return check_valindex ( valindex, N, nvalues );
+}
+
+/**
+ * @brief Check all column combinations that extend a combination of depth columns
+ *
+ * The value indices of the prefix of the column combination are stored in the buffer at position (depth-1)*N, so
+ * each combination of t columns costs a single pass over the rows.
+ *
+ * @return False if an unbalanced column combination was found
+ */
+static bool strength_check_subtree ( const array_link &al, const array_t *s, int strength, int depth, int col, int nvalues, int *buffer, const int &abort )
+{
+	const int N = al.n_rows;
+	const int k = al.n_columns;
+
+	int *valindex = buffer+depth*N;
+	const array_t *c = al.array+N*col;
+	const int st = s[col];
+	if ( depth==0 ) {
+		for ( int r=0; r<N; r++ )
+			valindex[r] = c[r];
+	} else {
+		const int *prev = buffer+ ( depth-1 ) *N;
+		for ( int r=0; r<N; r++ )
+			valindex[r] = prev[r]*st+c[r];
+	}
+	nvalues *= st;
+
+	if ( depth==strength-1 )
+		return check_valindex ( valindex, N, nvalues );
+
+	// the number of t-tuples of all extensions is a multiple of nvalues
+	if ( N % nvalues != 0 )
+		return false;
+
+	for ( int c2=col+1; c2<=k- ( strength-depth-1 ); c2++ ) {
+		if ( readsharedflag ( abort ) )
+			return true;
+		if ( ! strength_check_subtree ( al, s, strength, depth+1, c2, nvalues, buffer, abort ) )
+			return false;
+	}
+	return true;
+}
+
+bool strength_check_lattice ( const array_link &al, const array_t *s, int strength, int verbose )
+{
+	const int N = al.n_rows;
+	const int k = al.n_columns;
+
+	if ( strength<=0 )
+		return true;
+	if ( strength>k )
+		return true;
+
+	int abort=0;
+
+	// distribute the subtrees of the first column over the threads, if there is enough work
+	const bool doparallel = ( ncombsm<double> ( k, strength ) *N ) > 200000;
+
+#ifdef DOOPENMP
+	#pragma omp parallel if(doparallel)
+#endif
+	{
+		std::vector<int> buffer ( strength*N );
+
+#ifdef DOOPENMP
+		#pragma omp for schedule(dynamic,1)
+#endif
+		for ( int c=0; c<=k-strength; c++ ) {
+			if ( readsharedflag ( abort ) )
+				continue;
+			if ( ! strength_check_subtree ( al, s, strength, 0, c, 1, &buffer[0], abort ) ) {
+				if ( verbose>=2 )
+					myprintf ( "strength_check_lattice: strength %d: unbalanced combination starting at column %d\n", strength, c );
+				setsharedflag ( abort, 1 );
+			}
+		}
+	}
+	( void ) doparallel;
+
+	return abort==0;
+}
+
+int arraystrength ( const array_link &al, int verbose )
+{
+	arraydata_t ad = arraylink2arraydata ( al, 0, 0 );
+
+	for ( int t=1; t<=al.n_columns; t++ ) {
+		if ( ! strength_check_lattice ( al, ad.s, t, verbose ) ) {
+			if ( verbose )
+				myprintf ( "arraystrength: array has strength %d\n", t-1 );
+			return t-1;
+		}
+	}
+	return al.n_columns;
+}
+
+bool strength_check_colcombs ( const array_link &al, const array_t *s, colindex_t **colcombs, int ncolcombs, int strength, int verbose )
+{
+	const int N = al.n_rows;
+	int val=1;
+
+	// only use multiple threads if there is enough work
+	const bool doparallel = ( ( long ) ncolcombs*N ) > 200000;
+
+#ifdef DOOPENMP
+	#pragma omp parallel if(doparallel)
+#endif
+	{
+		std::vector<int> valindex ( N );
+
+#ifdef DOOPENMP
+		#pragma omp for schedule(dynamic,16)
+#endif
+		for ( int i=0; i<ncolcombs; i++ ) {
+			if ( ! readsharedflag ( val ) )
+				continue;
+
+			if ( ! check_colcomb ( al, s, colcombs[i], strength, &valindex[0] ) ) {
+				if ( verbose>=2 ) {
+					myprintf ( "no good strength: column combination %d: ", i );
+					print_perm ( colcombs[i], strength );
+				}
+				setsharedflag ( val, 0 );
+			}
+		}
+	}
+	( void ) doparallel;
+
+	return val!=0;
+}
+
 bool strength_check ( const arraydata_t &ad, const array_link &al,  int verbose )
 {
 #ifdef OADEBUG
-myassert(ad.ncols>=al.n_columns, "strength_check: array has too many columns");
-    #endif
-    
-    strength_check_t strengthcheck ( ad.strength );
-
-    //int oaindextmin = get_oaindex ( ad.s, ad.strength-1, ad.N );
-
-    /* set column combinations with extending column fixed */
-
-    int fixcol=al.n_columns-1;
-    if ( verbose>=2 )
-        myprintf ( "strength_check array: N %d, k %d, strength %d\n", ad.N, al.n_columns, ad.strength );
-    strengthcheck.colcombs = set_colcombs_fixed ( strengthcheck.lambda, strengthcheck.nvalues, strengthcheck.ncolcombs, ad.s, ad.strength, fixcol, ad.N );
-
-    //myprintf ( "nvalues: " ); print_perm ( nvalues, strengthcheck.ncolcombs );
-    strengthcheck.indices = set_indices ( strengthcheck.colcombs, ad.s, ad.strength, strengthcheck.ncolcombs );	//sets indices for frequencies, does the malloc as well
-    strengthcheck.create_reverse_colcombs_fixed();
-
-//	strengthcheck.r_index = create_reverse_colcombs_fixed(ncolcombs);
-
-
-    int val=true;
-    strengthcheck.freqtable = new_strength_freq_table ( strengthcheck.ncolcombs, strengthcheck.nvalues, strengthcheck.freqtablesize );
-
-    if ( verbose>=2 )
-        strengthcheck.info();
-
-    if ( verbose>=2 ) {
-        myprintf ( "before:\n" );
-        strengthcheck.print_frequencies ( );
-    }
-//   myprintf ( "  table of size %d\n", strengthcheck.freqtablesize );
-//   myprintf ( "  strength %d: %d\n", ad.strength, val );
-
-	array_t **arraycol = new array_t* [ad.strength];
-	int *sss =  new int[ad.strength];
-
-	for ( int i=0; i<strengthcheck.ncolcombs; i++ ) {
-        //myprintf ( "columns %d: ", i ); print_perm ( strengthcheck.colcombs[i], strength );
-
-
-	/// cache values of levels and column pointers
-	for ( int t=0; t<ad.strength; t++ ) arraycol[t] = al.array+ad.N*strengthcheck.colcombs[i][t];
-	 for ( int t=0; t<ad.strength; t++ ) sss[t]= ad.s[strengthcheck.colcombs[i][t]];
-	  
-     for ( int r=0; r<ad.N; r++ ) {
-            int valindex=0;
-	    //carray_t *arrayrow = al.array+r;
-            for ( int t=0; t<ad.strength; t++ ) {
-                //colindex_t cc = strengthcheck.colcombs[i][t];
-                //int s = ad.s[cc];
-                //array_t val = al.array[cc*ad.N+r];
-	      int s = sss[t];
-                array_t val = arraycol[t][r];
-                valindex = valindex*s+val;
-            }
-            if ( verbose>=2 ) {
-                myprintf ( "  row %d: ", r );
-                myprintf ( " value index %d\n", valindex );
-            }
-            strengthcheck.freqtable[i][valindex]++;
-        }
-// myprintf ( "columns %d: ...\n ", i );
-
-        for ( int j=0; j<strengthcheck.nvalues[i]; j++ ) {
-            //    myprintf ( "strength: i %d, j %d: %d %d\n", i, j, strengthcheck.freqtable[i][j], nvalues[i] );
-            if ( strengthcheck.freqtable[i][j]!=ad.N/strengthcheck.nvalues[i] ) {
-                if ( verbose>=2 )
-                    myprintf ( "no good strength: i %d, j %d: %d %d\n", i, j, strengthcheck.freqtable[i][j], strengthcheck.nvalues[i] );
-                val=false;
-                break;
-            }
-        }
-
-        if ( val==false )
-            break;
-    }
-    //myprintf ( "nvalues: " ); print_perm ( nvalues, strengthcheck.ncolcombs );
-    if ( verbose>=2 ) {
-        myprintf ( "table of counted value pairs\n" );
-        strengthcheck.print_frequencies ( );
-    }
-//	print_frequencies(strengthcheck.freqtable, strengthcheck.ncolcombs, nvalues, ad.N);
-
-	delete sss;
-	delete [] arraycol;
-    return val;
+	myassert ( ad.ncols>=al.n_columns, "strength_check: array has too many columns" );
+#endif
+
+	/* set column combinations with extending column fixed */
+	int fixcol=al.n_columns-1;
+	if ( verbose>=2 )
+		myprintf ( "strength_check array: N %d, k %d, strength %d\n", ad.N, al.n_columns, ad.strength );
+
+	int *lambda, *nvalues;
+	int ncolcombs;
+	colindex_t **colcombs = set_colcombs_fixed ( lambda, nvalues, ncolcombs, ad.s, ad.strength, fixcol, ad.N );
+
+	bool val = strength_check_colcombs ( al, ad.s, colcombs, ncolcombs, ad.strength, verbose );
+
+	free_colcombs_fixed ( colcombs, lambda, nvalues );
+	return val;
+}
+
+bool strength_check ( const array_link &al, int strength,  int verbose )
+{
+	if ( strength==0 )
+		return true;
+
+	arraydata_t ad = arraylink2arraydata ( al, 0, strength );
+	if ( verbose>=2 )
+		myprintf ( "strength_check array: N %d, k %d, strength %d\n", ad.N, al.n_columns, strength );
+
+	return strength_check_lattice ( al, ad.s, strength, verbose );
 }
 
+std::vector<int> strength_check ( const arraylist_t &arraylist, int strength, int verbose )
+{
+	const long narrays = arraylist.size();
+	std::vector<int> result ( narrays );
+
+	if ( verbose )
+		myprintf ( "strength_check: %ld arrays, strength %d\n", narrays, strength );
 
+#ifdef DOOPENMP
+	#pragma omp parallel for schedule(dynamic,4)
+#endif
+	for ( long i=0; i<narrays; i++ ) {
+		result[i] = strength_check ( arraylist[i], strength, verbose>=3 );
+	}
+
+	return result;
+}
 
 /*!
   check_divisibility checks if the number of runs is a multiple of any combination of the number of factors. 
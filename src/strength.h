@@ -146,6 +146,54 @@ struct strength_check_t {
 
 };
 
+/** @brief Frequency table of the t-tuples in all column combinations of an array
+ *
+ * The table is used to maintain the strength of an array during optimization. Changing a single element of the
+ * array only updates the counts of the column combinations that contain the column of the element. The number of
+ * entries in the table that differ from lambda is tracked, so the strength can be tested in constant time.
+ */
+struct strength_freqtable_t : public strength_check_t {
+	/// number of rows
+	const rowindex_t N;
+	/// number of columns
+	const colindex_t ncols;
+	/// for each column the column combinations containing the column
+	rev_index *col_index;
+	/// number of entries in the frequency table not equal to lambda
+	int nbad;
+	/// sum of the squared differences between the entries in the frequency table and lambda
+	long sqdev;
+
+	strength_freqtable_t ( const arraydata_t &ad, int strength );
+	~strength_freqtable_t();
+
+	/// count the t-tuples of an array
+	void init_frequencies ( const array_link &al );
+
+	/** @brief Update the frequency table for a change of a single element
+	 *
+	 * The update should be made before the array itself is changed.
+	 */
+	void update ( const array_link &al, rowindex_t r, colindex_t c, array_t value );
+
+	/// return true if all t-tuples occur equally often
+	bool isbalanced() const {
+		return nbad==0;
+	}
+
+private:
+	void addcount ( int i, int pos, int delta ) {
+		freq_t &f = freqtable[i][pos];
+		const long d = f-lambda[i];
+		nbad -= ( d!=0 );
+		f += delta;
+		nbad += ( f!=lambda[i] );
+		sqdev += ( 2*d+delta ) *delta;
+	}
+	strength_freqtable_t ( const strength_freqtable_t & );
+	strength_freqtable_t &operator= ( const strength_freqtable_t & );
+};
+
 /** @brief Contains static data for the extend loop
  *
  */
@@ -232,7 +280,7 @@ void init_frequencies ( extend_data_t *es, array_t *array );
 
 void recount_frequencies ( int **frequencies, extend_data_t *es, colindex_t currentcol, rowindex_t rowstart, rowindex_t rowlast, carray_t *array );
 
-/// perform strength check on an array
+/// perform strength check on an array, only the column combinations containing the last column are checked
 bool strength_check ( const arraydata_t &ad, const array_link &al, int verbose=1 );
 
 template <class basetype>
@@ -256,81 +304,39 @@ vindex_t **set_indices ( colindex_t **colcombs, basetype *bases, const int k, co
 }
 
 /// perform strength check on an array
-inline bool strength_check ( const array_link &al, int strength,  int verbose = 0 )
-{
-	if ( strength==0 )
-		return true;
-
-
-	arraydata_t ad = arraylink2arraydata ( al, 0, strength );
-	strength_check_t strengthcheck ( strength );
-
-	int oaindextmin = get_oaindex ( ad.s, ad.strength-1, ad.N );
-
-	/* set column combinations with extending column fixed */
-
-	if ( verbose>=2 )
-		myprintf ( "strength_check array: N %d, k %d, strength %d\n", ad.N, al.n_columns, ad.strength );
-	strengthcheck.set_colcombs ( ad );
-
-	//myprintf ( "nvalues: " ); print_perm ( nvalues, strengthcheck.ncolcombs );
-	strengthcheck.indices = set_indices ( strengthcheck.colcombs, ad.s, ad.strength, strengthcheck.ncolcombs );	//sets indices for frequencies, does the malloc as well
-
-	strengthcheck.create_reverse_colcombs_fixed();
-
-	int val=true;
-	strengthcheck.freqtable = new_strength_freq_table ( strengthcheck.ncolcombs, strengthcheck.nvalues, strengthcheck.freqtablesize );
-
-	if ( verbose>=2 )
-		strengthcheck.info();
+bool strength_check ( const array_link &al, int strength,  int verbose = 0 );
 
-	if ( verbose>=2 ) {
-		myprintf ( "before:\n" );
-		strengthcheck.print_frequencies ( );
-	}
-//   myprintf ( "  table of size %d\n", strengthcheck.freqtablesize );
-//   myprintf ( "  strength %d: %d\n", ad.strength, val );
-
-	for ( int i=0; i<strengthcheck.ncolcombs; i++ ) {
-		//myprintf ( "columns %d: ", i ); print_perm ( strengthcheck.colcombs[i], strength );
-
-		for ( int r=0; r<ad.N; r++ ) {
-
-			int valindex=0;
-			for ( int t=0; t<ad.strength; t++ ) {
-				colindex_t cc = strengthcheck.colcombs[i][t];
-				int s = ad.s[cc];
-				array_t val = al.array[cc*ad.N+r];
-				valindex = valindex*s+val;
-			}
-			if ( verbose>=2 ) {
-				myprintf ( "  row %d: ", r );
-				myprintf ( " value index %d\n", valindex );
-			}
-			strengthcheck.freqtable[i][valindex]++;
-		}
+/// perform strength check on a list of arrays, the result contains 1 for each array with the specified strength
+std::vector<int> strength_check ( const arraylist_t &arraylist, int strength,  int verbose = 0 );
 
-		for ( int j=0; j<strengthcheck.nvalues[i]; j++ ) {
-			//    myprintf ( "strength: i %d, j %d: %d %d\n", i, j, strengthcheck.freqtable[i][j], nvalues[i] );
-			if ( strengthcheck.freqtable[i][j]!=ad.N/strengthcheck.nvalues[i] ) {
-				if ( verbose>=2 )
-					myprintf ( "no good strength: i %d, j %d: %d %d\n", i, j, strengthcheck.freqtable[i][j], strengthcheck.nvalues[i] );
-				val=false;
-				break;
-			}
-		}
+/** @brief Perform strength check on a set of column combinations of an array
+ *
+ * The check stops at the first column combination in which a t-tuple of values occurs more often than N/nvalues.
+ * For large arrays the column combinations are distributed over multiple threads.
+ */
+bool strength_check_colcombs ( const array_link &al, const array_t *s, colindex_t **colcombs, int ncolcombs, int strength, int verbose = 0 );
 
-		if ( val==false )
-			break;
-	}
-	//myprintf ( "nvalues: " ); print_perm ( nvalues, strengthcheck.ncolcombs );
-	if ( verbose>=2 ) {
-		myprintf ( "table of counted value pairs\n" );
-		strengthcheck.print_frequencies ( );
-	}
+/** @brief Perform strength check on all column combinations of an array
+ *
+ * The column combinations are enumerated depth-first. The value indices of a combination of t columns are calculated
+ * from the value indices of its first t-1 columns, so every combination costs a single pass over the rows.
+ *
+ * @param al Array to check
+ * @param s Factor levels of the columns
+ * @param strength Strength to check
+ * @param verbose Verbosity level
+ * @return True if all column combinations of size strength are balanced
+ */
+bool strength_check_lattice ( const array_link &al, const array_t *s, int strength, int verbose = 0 );
 
-	return val;
-}
+/** @brief Return the strength of an array
+ *
+ * The strength is the largest t such that all combinations of t columns are balanced. The strengths 1, 2, ... are
+ * checked in turn and the check stops at the first unbalanced column combination. Within the check of a strength t
+ * the value indices of a combination of t-1 columns are shared by all its extensions, the counts are not kept
+ * between the checks of different strengths.
+ */
+int arraystrength ( const array_link &al, int verbose = 0 );
 
 #ifdef FULLPACKAGE
 bool valid_element ( const extend_data_t *es, const extendpos *p, carray_t *array );